@@ -0,0 +1,40 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ampheck_align_h
+#define ampheck_align_h
+
+/*
+	AMPHECK_ALIGNED(n) goes in front of a member to align it to `n' bytes,
+	and with it the whole context.  The library and its users must agree on
+	the layout of the contexts, so there is no fallback that leaves the
+	alignment out.
+*/
+#if defined(__cplusplus) && __cplusplus >= 201103L
+#define AMPHECK_ALIGNED(n) alignas(n)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define AMPHECK_ALIGNED(n) _Alignas(n)
+#elif defined(__GNUC__)
+#define AMPHECK_ALIGNED(n) __attribute__((aligned(n)))
+#elif defined(_MSC_VER)
+#define AMPHECK_ALIGNED(n) __declspec(align(n))
+#else
+#error "ampheck: no way to align the contexts with this compiler"
+#endif
+
+#endif
@@ -0,0 +1,600 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ampheck_hpp
+#define ampheck_hpp
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+extern "C"
+{
+#include "md4.h"
+#include "md5.h"
+#include "ripemd128.h"
+#include "ripemd160.h"
+#include "sha0.h"
+#include "sha1.h"
+#include "sha224.h"
+#include "sha256.h"
+#include "sha384.h"
+#include "sha512.h"
+#include "sha512_224.h"
+#include "sha512_256.h"
+}
+
+/*
+	C++ layer over the C functions, for C++20.
+
+	ampheck::sha256 and its siblings own a context, are move-only and take
+	std::span input.  Their static digest() hashes a whole message: through
+	ampheck_<algo>_digest() at run time, and for MD4, MD5 and the SHA-2
+	family also in constant expressions, so that digests of compile-time
+	constants end up in the binary:
+
+		constexpr auto tag = ampheck::sha256::digest("protocol tag");
+
+	digest() also takes a std::array or a std::span of static extent, such
+	as the 16, 20, 32 and 64 bytes of keys and digests.  In a constant
+	expression the length is known along with the padding; at run time
+	these go through ampheck_<algo>_digest() and the selected backend like
+	the other overloads.
+*/
+namespace ampheck
+{
+	namespace detail
+	{
+		constexpr std::uint32_t rol(std::uint32_t x, int n) noexcept
+		{
+			return (x << n) | (x >> (32 - n));
+		}
+		
+		constexpr std::uint32_t ror(std::uint32_t x, int n) noexcept
+		{
+			return (x >> n) | (x << (32 - n));
+		}
+		
+		constexpr std::uint64_t ror(std::uint64_t x, int n) noexcept
+		{
+			return (x >> n) | (x << (64 - n));
+		}
+		
+		/* Runs f.template operator()<t>() for t = 0 to N - 1, unrolled. */
+		template <std::size_t N, typename F>
+		constexpr void unroll(F &&f) noexcept
+		{
+			[&]<std::size_t... t>(std::index_sequence<t...>)
+			{
+				(f.template operator()<t>(), ...);
+			}(std::make_index_sequence<N>{});
+		}
+		
+		inline constexpr std::uint8_t md4_index[48] =
+		{
+			 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15,
+			 0,  4,  8, 12,  1,  5,  9, 13,  2,  6, 10, 14,  3,  7, 11, 15,
+			 0,  8,  4, 12,  2, 10,  6, 14,  1,  9,  5, 13,  3, 11,  7, 15
+		};
+		
+		inline constexpr std::uint8_t md4_shift[48] =
+		{
+			 3,  7, 11, 19,  3,  7, 11, 19,  3,  7, 11, 19,  3,  7, 11, 19,
+			 3,  5,  9, 13,  3,  5,  9, 13,  3,  5,  9, 13,  3,  5,  9, 13,
+			 3,  9, 11, 15,  3,  9, 11, 15,  3,  9, 11, 15,  3,  9, 11, 15
+		};
+		
+		inline constexpr std::uint8_t md5_index[64] =
+		{
+			 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15,
+			 1,  6, 11,  0,  5, 10, 15,  4,  9, 14,  3,  8, 13,  2,  7, 12,
+			 5,  8, 11, 14,  1,  4,  7, 10, 13,  0,  3,  6,  9, 12, 15,  2,
+			 0,  7, 14,  5, 12,  3, 10,  1,  8, 15,  6, 13,  4, 11,  2,  9
+		};
+		
+		inline constexpr std::uint8_t md5_shift[64] =
+		{
+			 7, 12, 17, 22,  7, 12, 17, 22,  7, 12, 17, 22,  7, 12, 17, 22,
+			 5,  9, 14, 20,  5,  9, 14, 20,  5,  9, 14, 20,  5,  9, 14, 20,
+			 4, 11, 16, 23,  4, 11, 16, 23,  4, 11, 16, 23,  4, 11, 16, 23,
+			 6, 10, 15, 21,  6, 10, 15, 21,  6, 10, 15, 21,  6, 10, 15, 21
+		};
+		
+		inline constexpr std::uint32_t md5_k[64] =
+		{
+			0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+			0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+			0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+			0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+			0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+			0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+			0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+			0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+		};
+		
+		inline constexpr std::uint32_t sha256_k[64] =
+		{
+			0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+			0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+			0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+			0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+			0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+			0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+			0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+			0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+		};
+		
+		inline constexpr std::uint64_t sha512_k[80] =
+		{
+			0x428a2f98d728ae22, 0x7137449123ef65cd, 0xb5c0fbcfec4d3b2f, 0xe9b5dba58189dbbc,
+			0x3956c25bf348b538, 0x59f111f1b605d019, 0x923f82a4af194f9b, 0xab1c5ed5da6d8118,
+			0xd807aa98a3030242, 0x12835b0145706fbe, 0x243185be4ee4b28c, 0x550c7dc3d5ffb4e2,
+			0x72be5d74f27b896f, 0x80deb1fe3b1696b1, 0x9bdc06a725c71235, 0xc19bf174cf692694,
+			0xe49b69c19ef14ad2, 0xefbe4786384f25e3, 0x0fc19dc68b8cd5b5, 0x240ca1cc77ac9c65,
+			0x2de92c6f592b0275, 0x4a7484aa6ea6e483, 0x5cb0a9dcbd41fbd4, 0x76f988da831153b5,
+			0x983e5152ee66dfab, 0xa831c66d2db43210, 0xb00327c898fb213f, 0xbf597fc7beef0ee4,
+			0xc6e00bf33da88fc2, 0xd5a79147930aa725, 0x06ca6351e003826f, 0x142929670a0e6e70,
+			0x27b70a8546d22ffc, 0x2e1b21385c26c926, 0x4d2c6dfc5ac42aed, 0x53380d139d95b3df,
+			0x650a73548baf63de, 0x766a0abb3c77b2a8, 0x81c2c92e47edaee6, 0x92722c851482353b,
+			0xa2bfe8a14cf10364, 0xa81a664bbc423001, 0xc24b8b70d0f89791, 0xc76c51a30654be30,
+			0xd192e819d6ef5218, 0xd69906245565a910, 0xf40e35855771202a, 0x106aa07032bbd1b8,
+			0x19a4c116b8d2d0c8, 0x1e376c085141ab53, 0x2748774cdf8eeb99, 0x34b0bcb5e19b48a8,
+			0x391c0cb3c5c95a63, 0x4ed8aa4ae3418acb, 0x5b9cca4f7763e373, 0x682e6ff3d6b2b8a3,
+			0x748f82ee5defb2fc, 0x78a5636f43172f60, 0x84c87814a1f0ab72, 0x8cc702081a6439ec,
+			0x90befffa23631e28, 0xa4506cebde82bde9, 0xbef9a3f7b2c67915, 0xc67178f2e372532b,
+			0xca273eceea26619c, 0xd186b8c721c0c207, 0xeada7dd6cde0eb1e, 0xf57d4f7fee6ed178,
+			0x06f067aa72176fba, 0x0a637dc5a2c898a6, 0x113f9804bef90dae, 0x1b710b35131c471b,
+			0x28db77f523047d84, 0x32caab7b40c72493, 0x3c9ebe0a15c9bebc, 0x431d67c49c100d4c,
+			0x4cc5d4becb3e42b6, 0x597f299cfc657e2a, 0x5fcb6fab3ad6faec, 0x6c44198c4a475817
+		};
+		
+		constexpr void md4_compress(std::array<std::uint32_t, 4> &h, std::array<std::uint32_t, 16> w) noexcept
+		{
+			std::uint32_t a = h[0], b = h[1], c = h[2], d = h[3];
+			
+			unroll<48>([&]<std::size_t t>()
+			{
+				std::uint32_t f;
+				
+				if constexpr (t < 16)
+				{
+					f = d ^ (b & (c ^ d));
+				}
+				else if constexpr (t < 32)
+				{
+					f = ((b & c) | (d & (b | c))) + 0x5a827999;
+				}
+				else
+				{
+					f = (b ^ c ^ d) + 0x6ed9eba1;
+				}
+				
+				std::uint32_t x = rol(a + f + w[md4_index[t]], md4_shift[t]);
+				
+				a = d;
+				d = c;
+				c = b;
+				b = x;
+			});
+			
+			h[0] += a;
+			h[1] += b;
+			h[2] += c;
+			h[3] += d;
+		}
+		
+		constexpr void md5_compress(std::array<std::uint32_t, 4> &h, std::array<std::uint32_t, 16> w) noexcept
+		{
+			std::uint32_t a = h[0], b = h[1], c = h[2], d = h[3];
+			
+			unroll<64>([&]<std::size_t t>()
+			{
+				std::uint32_t f;
+				
+				if constexpr (t < 16)
+				{
+					f = d ^ (b & (c ^ d));
+				}
+				else if constexpr (t < 32)
+				{
+					f = c ^ (d & (b ^ c));
+				}
+				else if constexpr (t < 48)
+				{
+					f = b ^ c ^ d;
+				}
+				else
+				{
+					f = c ^ (b | ~d);
+				}
+				
+				std::uint32_t x = b + rol(a + f + md5_k[t] + w[md5_index[t]], md5_shift[t]);
+				
+				a = d;
+				d = c;
+				c = b;
+				b = x;
+			});
+			
+			h[0] += a;
+			h[1] += b;
+			h[2] += c;
+			h[3] += d;
+		}
+		
+		/* SHA-256 and SHA-512 differ in word size, rotation counts and round count only. */
+		template <typename Word, int Rounds, int S0a, int S0b, int S0c, int S1a, int S1b, int S1c,
+		          int T0a, int T0b, int T0c, int T1a, int T1b, int T1c, const Word *K>
+		constexpr void sha2_compress(std::array<Word, 8> &h, std::array<Word, 16> w) noexcept
+		{
+			std::array<Word, 8> v = h;
+			
+			unroll<Rounds>([&]<std::size_t t>()
+			{
+				if constexpr (t >= 16)
+				{
+					Word x = w[(t + 1) & 15];
+					Word y = w[(t - 2) & 15];
+					
+					w[t & 15] += (ror(x, S0a) ^ ror(x, S0b) ^ (x >> S0c)) + (ror(y, S1a) ^ ror(y, S1b) ^ (y >> S1c)) + w[(t - 7) & 15];
+				}
+				
+				Word t1 = v[7] + (ror(v[4], T1a) ^ ror(v[4], T1b) ^ ror(v[4], T1c)) + (v[6] ^ (v[4] & (v[5] ^ v[6]))) + K[t] + w[t & 15];
+				Word t2 = (ror(v[0], T0a) ^ ror(v[0], T0b) ^ ror(v[0], T0c)) + ((v[0] & v[1]) | (v[2] & (v[0] | v[1])));
+				
+				v = { t1 + t2, v[0], v[1], v[2], v[3] + t1, v[4], v[5], v[6] };
+			});
+			
+			for (int i = 0; i < 8; ++i)
+			{
+				h[i] += v[i];
+			}
+		}
+		
+		constexpr void sha256_compress(std::array<std::uint32_t, 8> &h, const std::array<std::uint32_t, 16> &w) noexcept
+		{
+			sha2_compress<std::uint32_t, 64, 7, 18, 3, 17, 19, 10, 2, 13, 22, 6, 11, 25, sha256_k>(h, w);
+		}
+		
+		constexpr void sha512_compress(std::array<std::uint64_t, 8> &h, const std::array<std::uint64_t, 16> &w) noexcept
+		{
+			sha2_compress<std::uint64_t, 80, 1, 8, 7, 19, 61, 6, 28, 34, 39, 14, 18, 41, sha512_k>(h, w);
+		}
+		
+		/* Reads a block of words from bytes of any byte-sized type, in the algorithm's byte order. */
+		template <typename Word, bool BigEndian, typename Byte>
+		constexpr std::array<Word, 16> load(const Byte *p) noexcept
+		{
+			std::array<Word, 16> w{};
+			
+			for (std::size_t i = 0; i < 16 * sizeof(Word); ++i)
+			{
+				Word byte = static_cast<std::uint8_t>(p[i]);
+				
+				w[i / sizeof(Word)] |= byte << (BigEndian ? (sizeof(Word) - 1 - i % sizeof(Word)) * 8 : (i % sizeof(Word)) * 8);
+			}
+			
+			return w;
+		}
+		
+		/*
+			Hashes `length' bytes of `data' with the compression function of
+			`T'.  When `length' is a constant, as it is from the fixed-length
+			overloads, so is the layout of the padding.
+		*/
+		template <typename T, typename Byte>
+		constexpr typename T::digest_type run(const Byte *data, std::size_t length) noexcept
+		{
+			using word = typename T::word_type;
+			constexpr std::size_t block = 16 * sizeof(word);
+			std::array<word, T::state_words> h = T::iv;
+			std::array<std::uint8_t, 2 * block> final{};
+			const std::size_t rest = length % block;
+			const std::size_t blocks = rest + 1 + block / 8 > block ? 2 : 1;
+			typename T::digest_type digest{};
+			
+			for (std::size_t i = 0; i + block <= length; i += block)
+			{
+				T::compress(h, load<word, T::big_endian>(&data[i]));
+			}
+			
+			for (std::size_t i = 0; i < rest; ++i)
+			{
+				final[i] = static_cast<std::uint8_t>(data[length - rest + i]);
+			}
+			
+			final[rest] = 0x80;
+			
+			for (std::size_t i = 0; i < 8; ++i)
+			{
+				std::uint8_t byte = static_cast<std::uint8_t>(static_cast<std::uint64_t>(length) * 8 >> (i * 8));
+				
+				if constexpr (T::big_endian)
+				{
+					final[blocks * block - 1 - i] = byte;
+				}
+				else
+				{
+					final[blocks * block - block / 8 + i] = byte;
+				}
+			}
+			
+			for (std::size_t i = 0; i < blocks; ++i)
+			{
+				T::compress(h, load<word, T::big_endian>(&final[i * block]));
+			}
+			
+			for (std::size_t i = 0; i < digest.size(); ++i)
+			{
+				word value = h[i / sizeof(word)];
+				
+				digest[i] = static_cast<std::uint8_t>(value >> (T::big_endian ? (sizeof(word) - 1 - i % sizeof(word)) * 8 : (i % sizeof(word)) * 8));
+			}
+			
+			return digest;
+		}
+		
+		template <typename T>
+		concept has_rounds = requires { T::iv; };
+		
+#define AMPHECK_TRAITS(algo, bytes) \
+		struct algo##_traits \
+		{ \
+			using context_type = ampheck_##algo; \
+			using digest_type = std::array<std::uint8_t, bytes>; \
+			\
+			static void init(context_type *ctx) noexcept { ampheck_##algo##_init(ctx); } \
+			static void update(context_type *ctx, const std::uint8_t *data, std::size_t length) noexcept { ampheck_##algo##_update(ctx, data, length); } \
+			static void finish(const context_type *ctx, std::uint8_t *digest) noexcept { ampheck_##algo##_finish(ctx, digest); } \
+			static void finish_inplace(context_type *ctx, std::uint8_t *digest) noexcept { ampheck_##algo##_finish_inplace(ctx, digest); } \
+			static void digest(const std::uint8_t *data, std::size_t length, std::uint8_t *digest) noexcept { ampheck_##algo##_digest(data, length, digest); }
+
+#define AMPHECK_ROUNDS(word, words, big, fn, ...) \
+			using word_type = word; \
+			static constexpr std::size_t state_words = words; \
+			static constexpr bool big_endian = big; \
+			static constexpr std::array<word, words> iv = { __VA_ARGS__ }; \
+			\
+			static constexpr void compress(std::array<word, words> &h, const std::array<word, 16> &w) noexcept { fn(h, w); }
+		
+		AMPHECK_TRAITS(md4, 16)
+			AMPHECK_ROUNDS(std::uint32_t, 4, false, md4_compress, 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476)
+		};
+		
+		AMPHECK_TRAITS(md5, 16)
+			AMPHECK_ROUNDS(std::uint32_t, 4, false, md5_compress, 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476)
+		};
+		
+		AMPHECK_TRAITS(ripemd128, 16)
+		};
+		
+		AMPHECK_TRAITS(ripemd160, 20)
+		};
+		
+		AMPHECK_TRAITS(sha0, 20)
+		};
+		
+		AMPHECK_TRAITS(sha1, 20)
+		};
+		
+		AMPHECK_TRAITS(sha224, 28)
+			AMPHECK_ROUNDS(std::uint32_t, 8, true, sha256_compress,
+			               0xc1059ed8, 0x367cd507, 0x3070dd17, 0xf70e5939, 0xffc00b31, 0x68581511, 0x64f98fa7, 0xbefa4fa4)
+		};
+		
+		AMPHECK_TRAITS(sha256, 32)
+			AMPHECK_ROUNDS(std::uint32_t, 8, true, sha256_compress,
+			               0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19)
+		};
+		
+		AMPHECK_TRAITS(sha384, 48)
+			AMPHECK_ROUNDS(std::uint64_t, 8, true, sha512_compress,
+			               0xcbbb9d5dc1059ed8, 0x629a292a367cd507, 0x9159015a3070dd17, 0x152fecd8f70e5939,
+			               0x67332667ffc00b31, 0x8eb44a8768581511, 0xdb0c2e0d64f98fa7, 0x47b5481dbefa4fa4)
+		};
+		
+		AMPHECK_TRAITS(sha512, 64)
+			AMPHECK_ROUNDS(std::uint64_t, 8, true, sha512_compress,
+			               0x6a09e667f3bcc908, 0xbb67ae8584caa73b, 0x3c6ef372fe94f82b, 0xa54ff53a5f1d36f1,
+			               0x510e527fade682d1, 0x9b05688c2b3e6c1f, 0x1f83d9abfb41bd6b, 0x5be0cd19137e2179)
+		};
+		
+		AMPHECK_TRAITS(sha512_224, 28)
+			AMPHECK_ROUNDS(std::uint64_t, 8, true, sha512_compress,
+			               0x8c3d37c819544da2, 0x73e1996689dcd4d6, 0x1dfab7ae32ff9c82, 0x679dd514582f9fcf,
+			               0x0f6d2b697bd44da8, 0x77e36f7304c48942, 0x3f9d85a86a1d36c8, 0x1112e6ad91d692a1)
+		};
+		
+		AMPHECK_TRAITS(sha512_256, 32)
+			AMPHECK_ROUNDS(std::uint64_t, 8, true, sha512_compress,
+			               0x22312194fc2bf72c, 0x9f555fa3c84c64c2, 0x2393b86b6f53b151, 0x963877195940eabd,
+			               0x96283ee2a88effe3, 0xbe5e1e2553863992, 0x2b0199fc2c85b8aa, 0x0eb72ddc81c52ca2)
+		};
+
+#undef AMPHECK_TRAITS
+#undef AMPHECK_ROUNDS
+	}
+	
+	template <typename T>
+	class basic_hash
+	{
+	public:
+		using traits_type = T;
+		using context_type = typename T::context_type;
+		using digest_type = typename T::digest_type;
+		
+		static constexpr std::size_t digest_size = std::tuple_size_v<digest_type>;
+		
+		basic_hash() noexcept
+		{
+			T::init(&ctx);
+		}
+		
+		basic_hash(const basic_hash &) = delete;
+		basic_hash &operator=(const basic_hash &) = delete;
+		
+		/* A moved-from object is left freshly initialised. */
+		basic_hash(basic_hash &&other) noexcept : ctx(other.ctx)
+		{
+			T::init(&other.ctx);
+		}
+		
+		basic_hash &operator=(basic_hash &&other) noexcept
+		{
+			if (this != &other)
+			{
+				ctx = other.ctx;
+				T::init(&other.ctx);
+			}
+			
+			return *this;
+		}
+		
+		basic_hash &update(std::span<const std::uint8_t> data) noexcept
+		{
+			T::update(&ctx, data.data(), data.size());
+			
+			return *this;
+		}
+		
+		basic_hash &update(std::span<const std::byte> data) noexcept
+		{
+			T::update(&ctx, reinterpret_cast<const std::uint8_t *>(data.data()), data.size());
+			
+			return *this;
+		}
+		
+		basic_hash &update(std::string_view data) noexcept
+		{
+			T::update(&ctx, reinterpret_cast<const std::uint8_t *>(data.data()), data.size());
+			
+			return *this;
+		}
+		
+		digest_type finish() const & noexcept
+		{
+			digest_type digest;
+			
+			T::finish(&ctx, digest.data());
+			
+			return digest;
+		}
+		
+		/* An rvalue pads in place instead of a copy and is left freshly initialised. */
+		digest_type finish() && noexcept
+		{
+			digest_type digest;
+			
+			T::finish_inplace(&ctx, digest.data());
+			T::init(&ctx);
+			
+			return digest;
+		}
+		
+		void reset() noexcept
+		{
+			T::init(&ctx);
+		}
+		
+		context_type *native() noexcept
+		{
+			return &ctx;
+		}
+		
+		static constexpr digest_type digest(std::span<const std::uint8_t> data) noexcept
+		{
+			if constexpr (detail::has_rounds<T>)
+			{
+				if (std::is_constant_evaluated())
+				{
+					return detail::run<T>(data.data(), data.size());
+				}
+			}
+			
+			digest_type digest;
+			
+			T::digest(data.data(), data.size(), digest.data());
+			
+			return digest;
+		}
+		
+		static constexpr digest_type digest(std::string_view data) noexcept
+		{
+			if constexpr (detail::has_rounds<T>)
+			{
+				if (std::is_constant_evaluated())
+				{
+					return detail::run<T>(data.data(), data.size());
+				}
+			}
+			
+			digest_type digest;
+			
+			T::digest(reinterpret_cast<const std::uint8_t *>(data.data()), data.size(), digest.data());
+			
+			return digest;
+		}
+		
+		/* Fixed lengths; see above. */
+		template <std::size_t N>
+			requires (N != std::dynamic_extent)
+		static constexpr digest_type digest(std::span<const std::uint8_t, N> data) noexcept
+		{
+			if constexpr (detail::has_rounds<T>)
+			{
+				if (std::is_constant_evaluated())
+				{
+					return detail::run<T>(data.data(), N);
+				}
+			}
+			
+			digest_type digest;
+			
+			T::digest(data.data(), N, digest.data());
+			
+			return digest;
+		}
+		
+		template <std::size_t N>
+		static constexpr digest_type digest(const std::array<std::uint8_t, N> &data) noexcept
+		{
+			return digest(std::span<const std::uint8_t, N>(data));
+		}
+		
+	private:
+		context_type ctx;
+	};
+	
+	using md4 = basic_hash<detail::md4_traits>;
+	using md5 = basic_hash<detail::md5_traits>;
+	using ripemd128 = basic_hash<detail::ripemd128_traits>;
+	using ripemd160 = basic_hash<detail::ripemd160_traits>;
+	using sha0 = basic_hash<detail::sha0_traits>;
+	using sha1 = basic_hash<detail::sha1_traits>;
+	using sha224 = basic_hash<detail::sha224_traits>;
+	using sha256 = basic_hash<detail::sha256_traits>;
+	using sha384 = basic_hash<detail::sha384_traits>;
+	using sha512 = basic_hash<detail::sha512_traits>;
+	using sha512_224 = basic_hash<detail::sha512_224_traits>;
+	using sha512_256 = basic_hash<detail::sha512_256_traits>;
+}
+
+#endif
@@ -0,0 +1,200 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ampheck_backends_h
+#define ampheck_backends_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cpu.h"
+#include "mgr.h"
+#include "md4.h"
+#include "md5.h"
+#include "ripemd128.h"
+#include "ripemd160.h"
+#include "sha0.h"
+#include "sha1.h"
+#include "sha256.h"
+#include "sha512.h"
+
+typedef void (*ampheck_backend_fn)(void);
+
+/*
+	Backend tables list the transforms of one algorithm in order of
+	preference and end with a NULL name.  `features' is the set of
+	AMPHECK_CPU_* bits a backend needs to run.
+*/
+struct ampheck_backend
+{
+	const char *name;
+	unsigned int features;
+	ampheck_backend_fn transform;
+};
+
+const struct ampheck_backend *ampheck_backend_select(const char *algorithm, const struct ampheck_backend *backends);
+
+/*
+	Multi-buffer kernels compress `blocks' blocks of `lanes' independent
+	messages at once.  `state' holds the chaining values word-sliced: word i
+	of lane l is element i * lanes + l.  An entry without a transform hashes
+	one message at a time with the single-stream transform.
+*/
+typedef void (*ampheck_lanes_fn)(void *state, const uint8_t *const data[], size_t blocks);
+
+struct ampheck_lanes
+{
+	const char *name;
+	unsigned int features;
+	unsigned int lanes;
+	ampheck_lanes_fn transform;
+};
+
+const struct ampheck_lanes *ampheck_lanes_select(const char *algorithm, const struct ampheck_lanes *lanes);
+
+/*
+	Describes an algorithm to the batch functions in batch.c: the layout of
+	its context (chaining values first, then the buffer and the length), its
+	padding and its digest.  `kernel' is resolved from `kernels' at first use.
+	The job manager there works on these too.
+*/
+struct ampheck_batch
+{
+	const char *algorithm;
+	const struct ampheck_lanes *kernels;
+	const struct ampheck_lanes *kernel;
+	void (*transform)(void *h, const uint8_t *data, size_t blocks);
+	void (*init)(void *ctx);
+	
+	size_t size;
+	size_t buffer;
+	size_t length;
+	size_t fill;
+	
+	unsigned int words;
+	unsigned int word;
+	unsigned int block;
+	unsigned int digest; /* in bytes */
+	int big_endian;
+};
+
+void ampheck_mgr_init(struct ampheck_mgr *mgr, struct ampheck_batch *batch);
+void ampheck_batch_update(struct ampheck_batch *batch, void *ctx, const uint8_t *const data[], const size_t length[], size_t count);
+void ampheck_batch_finish(struct ampheck_batch *batch, const void *ctx, uint8_t *const digest[], size_t count);
+
+/*
+	Builds the padded last block(s) of a `length' byte message in `final',
+	which must hold two blocks, from the last `length % block' bytes of the
+	message at `tail'.  Returns how many blocks there are.
+*/
+size_t ampheck_final(uint8_t *final, const uint8_t *tail, uint64_t length, unsigned int block, int big_endian);
+
+extern const struct ampheck_backend ampheck_md4_backends[];
+
+void ampheck_md4_transform(struct ampheck_md4 *ctx, const uint8_t *data, size_t blocks);
+void ampheck_md4_transform_generic(struct ampheck_md4 *ctx, const uint8_t *data, size_t blocks);
+
+extern const struct ampheck_lanes ampheck_md4_lanes[];
+
+extern const struct ampheck_backend ampheck_md5_backends[];
+
+void ampheck_md5_transform(struct ampheck_md5 *ctx, const uint8_t *data, size_t blocks);
+void ampheck_md5_transform_generic(struct ampheck_md5 *ctx, const uint8_t *data, size_t blocks);
+
+extern const struct ampheck_lanes ampheck_md5_lanes[];
+
+extern const struct ampheck_backend ampheck_ripemd128_backends[];
+
+void ampheck_ripemd128_transform(struct ampheck_ripemd128 *ctx, const uint8_t *data, size_t blocks);
+void ampheck_ripemd128_transform_generic(struct ampheck_ripemd128 *ctx, const uint8_t *data, size_t blocks);
+
+extern const struct ampheck_backend ampheck_ripemd160_backends[];
+
+void ampheck_ripemd160_transform(struct ampheck_ripemd160 *ctx, const uint8_t *data, size_t blocks);
+void ampheck_ripemd160_transform_generic(struct ampheck_ripemd160 *ctx, const uint8_t *data, size_t blocks);
+
+extern const struct ampheck_lanes ampheck_ripemd160_lanes[];
+
+extern const struct ampheck_backend ampheck_sha0_backends[];
+
+void ampheck_sha0_transform(struct ampheck_sha0 *ctx, const uint8_t *data, size_t blocks);
+void ampheck_sha0_transform_generic(struct ampheck_sha0 *ctx, const uint8_t *data, size_t blocks);
+
+extern const struct ampheck_backend ampheck_sha1_backends[];
+
+void ampheck_sha1_transform(struct ampheck_sha1 *ctx, const uint8_t *data, size_t blocks);
+void ampheck_sha1_transform_generic(struct ampheck_sha1 *ctx, const uint8_t *data, size_t blocks);
+
+extern const struct ampheck_lanes ampheck_sha1_lanes[];
+
+extern const struct ampheck_backend ampheck_sha256_backends[];
+
+/* The SHA-256 IV, for the code that compresses from it without a context. */
+extern const uint32_t ampheck_sha256_iv[8];
+
+void ampheck_sha256_transform(struct ampheck_sha256 *ctx, const uint8_t *data, size_t blocks);
+void ampheck_sha256_transform_generic(struct ampheck_sha256 *ctx, const uint8_t *data, size_t blocks);
+
+extern const struct ampheck_lanes ampheck_sha256_lanes[];
+
+/* SHA-256 of one message through the single-stream transform; see sha256d.c. */
+void ampheck_sha256_single(const uint8_t *data, size_t length, uint8_t *digest);
+
+/* SHA-256 of `count' messages of the same `length', in the lanes of the SHA-256 kernel; see sha256d.c. */
+void ampheck_sha256_fixed(const uint8_t *const data[], size_t length, uint8_t *const digest[], size_t count);
+
+extern const struct ampheck_lanes ampheck_sha256d_scan_lanes[];
+
+extern const struct ampheck_backend ampheck_sha512_backends[];
+
+void ampheck_sha512_transform(struct ampheck_sha512 *ctx, const uint8_t *data, size_t blocks);
+void ampheck_sha512_transform_generic(struct ampheck_sha512 *ctx, const uint8_t *data, size_t blocks);
+
+extern const struct ampheck_lanes ampheck_sha512_lanes[];
+
+/* The SHA-512 variants with their own IV and a digest of `size' bytes, on a SHA-512 context; see sha512.c. */
+void ampheck_sha512t_init(struct ampheck_sha512 *ctx, const uint64_t iv[8]);
+void ampheck_sha512t_finish(const struct ampheck_sha512 *ctx, uint8_t *digest, size_t size);
+void ampheck_sha512t_finish_inplace(struct ampheck_sha512 *ctx, uint8_t *digest, size_t size);
+void ampheck_sha512t_digest(const uint64_t iv[8], const uint8_t *data, size_t length, uint8_t *digest, size_t size);
+void ampheck_sha512_batch_transform(void *h, const uint8_t *data, size_t blocks);
+
+#ifdef AMPHECK_X86
+void ampheck_md4_lanes_avx2(void *state, const uint8_t *const data[], size_t blocks);
+void ampheck_md4_lanes_avx512(void *state, const uint8_t *const data[], size_t blocks);
+void ampheck_md5_lanes_avx2(void *state, const uint8_t *const data[], size_t blocks);
+void ampheck_md5_lanes_avx512(void *state, const uint8_t *const data[], size_t blocks);
+void ampheck_ripemd160_transform_avx2(struct ampheck_ripemd160 *ctx, const uint8_t *data, size_t blocks);
+void ampheck_ripemd160_lanes_avx2(void *state, const uint8_t *const data[], size_t blocks);
+void ampheck_ripemd160_lanes_avx512(void *state, const uint8_t *const data[], size_t blocks);
+void ampheck_sha0_transform_shani(struct ampheck_sha0 *ctx, const uint8_t *data, size_t blocks);
+void ampheck_sha1_transform_shani(struct ampheck_sha1 *ctx, const uint8_t *data, size_t blocks);
+void ampheck_sha1_transform_avx2(struct ampheck_sha1 *ctx, const uint8_t *data, size_t blocks);
+void ampheck_sha1_transform_ssse3(struct ampheck_sha1 *ctx, const uint8_t *data, size_t blocks);
+void ampheck_sha1_lanes_avx2(void *state, const uint8_t *const data[], size_t blocks);
+void ampheck_sha1_lanes_avx512(void *state, const uint8_t *const data[], size_t blocks);
+void ampheck_sha256_transform_shani(struct ampheck_sha256 *ctx, const uint8_t *data, size_t blocks);
+void ampheck_sha256_transform_avx2(struct ampheck_sha256 *ctx, const uint8_t *data, size_t blocks);
+void ampheck_sha256_lanes_avx2(void *state, const uint8_t *const data[], size_t blocks);
+void ampheck_sha256_lanes_avx512(void *state, const uint8_t *const data[], size_t blocks);
+void ampheck_sha512_transform_avx512(struct ampheck_sha512 *ctx, const uint8_t *data, size_t blocks);
+void ampheck_sha512_transform_avx2(struct ampheck_sha512 *ctx, const uint8_t *data, size_t blocks);
+void ampheck_sha512_lanes_avx2(void *state, const uint8_t *const data[], size_t blocks);
+void ampheck_sha512_lanes_avx512(void *state, const uint8_t *const data[], size_t blocks);
+#endif
+
+#endif
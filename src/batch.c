@@ -0,0 +1,495 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "ampheck.h"
+#include "backends.h"
+
+/*
+	The job manager behind both the ampheck_mgr_* functions and the batch
+	functions.  A job is split into stretches of whole blocks: the buffered
+	block it completes, if any, then its own blocks, then the padded final
+	blocks when it is the last one.  Every kernel call advances all lanes by
+	the blocks the shortest stretch has left, so no lane runs past the end of
+	its data, and a lane is freed for the next job as soon as its job is done.
+*/
+
+/* Copies are split by word size so that each becomes a plain move. */
+static void load(const struct ampheck_batch *batch, uint8_t *state, unsigned int lanes, unsigned int lane, const uint8_t *h)
+{
+	if (batch->word == 8)
+	{
+		for (unsigned int i = 0; i < batch->words; ++i)
+		{
+			memcpy(&state[(i * lanes + lane) * 8], &h[i * 8], 8);
+		}
+	}
+	else
+	{
+		for (unsigned int i = 0; i < batch->words; ++i)
+		{
+			memcpy(&state[(i * lanes + lane) * 4], &h[i * 4], 4);
+		}
+	}
+}
+
+static void store(const struct ampheck_batch *batch, const uint8_t *state, unsigned int lanes, unsigned int lane, uint8_t *h)
+{
+	if (batch->word == 8)
+	{
+		for (unsigned int i = 0; i < batch->words; ++i)
+		{
+			memcpy(&h[i * 8], &state[(i * lanes + lane) * 8], 8);
+		}
+	}
+	else
+	{
+		for (unsigned int i = 0; i < batch->words; ++i)
+		{
+			memcpy(&h[i * 4], &state[(i * lanes + lane) * 4], 4);
+		}
+	}
+}
+
+size_t ampheck_final(uint8_t *final, const uint8_t *tail, uint64_t length, unsigned int block, int big_endian)
+{
+	const size_t fill = length % block;
+	const size_t blocks = fill + 1 + block / 8 > block ? 2 : 1;
+	
+	memcpy(final, tail, fill);
+	
+	final[fill] = 0x80;
+	memset(&final[fill + 1], 0x00, blocks * block - fill - 1);
+	
+	length *= 8;
+	
+	for (size_t j = 0; j < 8; ++j)
+	{
+		if (big_endian)
+		{
+			final[blocks * block - 1 - j] = (uint8_t) (length >> (j * 8));
+		}
+		else
+		{
+			final[blocks * block - block / 8 + j] = (uint8_t) (length >> (j * 8));
+		}
+	}
+	
+	return blocks;
+}
+
+/* Builds the padded final block(s) of `ctx' in `final' and returns how many there are. */
+static size_t pad(const struct ampheck_batch *batch, const uint8_t *ctx, uint8_t *final)
+{
+	uint64_t total;
+	
+	memcpy(&total, &ctx[batch->length], sizeof(total));
+	
+	return ampheck_final(final, &ctx[batch->buffer], total, batch->block, batch->big_endian);
+}
+
+/* Whole words go to `full' first, so a digest may end inside a word. */
+static void serialize(const struct ampheck_batch *batch, const uint8_t *h, uint8_t *out)
+{
+	uint8_t full[64];
+	
+	for (unsigned int j = 0; j < batch->words; ++j)
+	{
+		if (batch->word == 8)
+		{
+			uint64_t value;
+			
+			memcpy(&value, &h[j * 8], 8);
+			UNPACK_64_BE(value, &full[j * 8]);
+		}
+		else if (batch->big_endian)
+		{
+			uint32_t value;
+			
+			memcpy(&value, &h[j * 4], 4);
+			UNPACK_32_BE(value, &full[j * 4]);
+		}
+		else
+		{
+			uint32_t value;
+			
+			memcpy(&value, &h[j * 4], 4);
+			UNPACK_32_LE(value, &full[j * 4]);
+		}
+	}
+	
+	memcpy(out, full, batch->digest);
+}
+
+/* Splits the data of `job' into stretches and counts it into the length of its context. */
+static void prepare(const struct ampheck_batch *batch, struct ampheck_job *job)
+{
+	const size_t block = batch->block;
+	uint8_t *c = job->ctx;
+	const uint8_t *p = job->data;
+	size_t size = job->length;
+	uint64_t total;
+	uint32_t fill;
+	
+	if (job->flags & AMPHECK_JOB_FIRST)
+	{
+		batch->init(c);
+	}
+	
+	memcpy(&total, &c[batch->length], sizeof(total));
+	memcpy(&fill, &c[batch->fill], sizeof(fill));
+	
+	job->fill = fill;
+	job->head = NULL;
+	job->final = 0;
+	
+	if (job->fill > 0 && size >= block - job->fill)
+	{
+		memcpy(&c[batch->buffer + job->fill], p, block - job->fill);
+		
+		p += block - job->fill;
+		size -= block - job->fill;
+		
+		job->head = &c[batch->buffer];
+		job->fill = 0;
+	}
+	
+	job->next = p;
+	job->blocks = job->fill == 0 ? size / block : 0;
+	job->rest = size - job->blocks * block;
+	job->tail = job->rest > 0 ? &p[size - job->rest] : NULL;
+	
+	total += job->length;
+	fill = (uint32_t) (total % block);
+	
+	memcpy(&c[batch->length], &total, sizeof(total));
+	memcpy(&c[batch->fill], &fill, sizeof(fill));
+}
+
+/* The tail is buffered only once the head block, which shares the buffer, is in. */
+static void buffer_tail(const struct ampheck_batch *batch, struct ampheck_job *job)
+{
+	if (job->tail != NULL)
+	{
+		memcpy((uint8_t *) job->ctx + batch->buffer + job->fill, job->tail, job->rest);
+		job->tail = NULL;
+	}
+}
+
+/* Points lane `l' at the next stretch of its job; returns 0 when there is none. */
+static int advance(struct ampheck_mgr *mgr, unsigned int l)
+{
+	struct ampheck_job *job = mgr->lane[l];
+	
+	if (job->head != NULL)
+	{
+		mgr->data[l] = job->head;
+		mgr->remaining[l] = 1;
+		job->head = NULL;
+		
+		return 1;
+	}
+	
+	if (job->blocks > 0)
+	{
+		mgr->data[l] = job->next;
+		mgr->remaining[l] = job->blocks;
+		job->blocks = 0;
+		
+		return 1;
+	}
+	
+	buffer_tail(mgr->batch, job);
+	
+	if ((job->flags & AMPHECK_JOB_LAST) && !job->final)
+	{
+		mgr->data[l] = mgr->final[l];
+		mgr->remaining[l] = pad(mgr->batch, job->ctx, mgr->final[l]);
+		job->final = 1;
+		
+		return 1;
+	}
+	
+	return 0;
+}
+
+/* Hands the job in lane `l', whose chaining values are back in its context, to the done list. */
+static void retire(struct ampheck_mgr *mgr, unsigned int l)
+{
+	struct ampheck_job *job = mgr->lane[l];
+	
+	if (job->flags & AMPHECK_JOB_LAST)
+	{
+		serialize(mgr->batch, job->ctx, job->digest);
+	}
+	
+	mgr->done[mgr->finished++] = job;
+	mgr->lane[l] = NULL;
+	--mgr->active;
+}
+
+static void step(struct ampheck_mgr *mgr)
+{
+	const unsigned int lanes = mgr->lanes;
+	uint8_t *state = (uint8_t *) mgr->state;
+	size_t blocks = SIZE_MAX;
+	unsigned int first = lanes;
+	
+	for (unsigned int l = 0; l < lanes; ++l)
+	{
+		if (mgr->lane[l] != NULL)
+		{
+			if (mgr->remaining[l] < blocks)
+			{
+				blocks = mgr->remaining[l];
+			}
+			
+			if (first == lanes)
+			{
+				first = l;
+			}
+		}
+	}
+	
+	/* Idle lanes rehash the data of a busy one; their results are dropped. */
+	for (unsigned int l = 0; l < lanes; ++l)
+	{
+		if (mgr->lane[l] == NULL)
+		{
+			mgr->data[l] = mgr->data[first];
+		}
+	}
+	
+	/* A single lane is laid out like a context, so the single-stream transform runs it as is. */
+	if (mgr->kernel->transform == NULL)
+	{
+		mgr->batch->transform(state, mgr->data[0], blocks);
+	}
+	else
+	{
+		mgr->kernel->transform(state, mgr->data, blocks);
+	}
+	
+	for (unsigned int l = 0; l < lanes; ++l)
+	{
+		if (mgr->lane[l] == NULL)
+		{
+			continue;
+		}
+		
+		mgr->data[l] += blocks * mgr->batch->block;
+		mgr->remaining[l] -= blocks;
+		
+		if (mgr->remaining[l] == 0 && !advance(mgr, l))
+		{
+			store(mgr->batch, state, lanes, l, mgr->lane[l]->ctx);
+			retire(mgr, l);
+		}
+	}
+}
+
+/* Finishes the job in lane `l' with the single-stream transform. */
+static void drain(struct ampheck_mgr *mgr, unsigned int l)
+{
+	uint8_t *c = mgr->lane[l]->ctx;
+	
+	store(mgr->batch, (uint8_t *) mgr->state, mgr->lanes, l, c);
+	
+	do
+	{
+		mgr->batch->transform(c, mgr->data[l], mgr->remaining[l]);
+	}
+	while (advance(mgr, l));
+	
+	retire(mgr, l);
+}
+
+void ampheck_mgr_init(struct ampheck_mgr *mgr, struct ampheck_batch *batch)
+{
+	const struct ampheck_lanes *kernel = AMPHECK_LOAD(batch->kernel);
+	
+	if (kernel == NULL)
+	{
+		kernel = ampheck_lanes_select(batch->algorithm, batch->kernels);
+		AMPHECK_STORE(batch->kernel, kernel);
+	}
+	
+	mgr->batch = batch;
+	mgr->kernel = kernel;
+	mgr->lanes = kernel->lanes;
+	mgr->active = 0;
+	mgr->finished = 0;
+	
+	for (unsigned int l = 0; l < AMPHECK_MGR_LANES; ++l)
+	{
+		mgr->lane[l] = NULL;
+	}
+}
+
+struct ampheck_job *ampheck_mgr_submit(struct ampheck_mgr *mgr, struct ampheck_job *job)
+{
+	unsigned int l = 0;
+	
+	prepare(mgr->batch, job);
+	
+	/* Data that only goes into the buffer needs no lane. */
+	if (job->head == NULL && job->blocks == 0 && !(job->flags & AMPHECK_JOB_LAST))
+	{
+		buffer_tail(mgr->batch, job);
+		
+		return job;
+	}
+	
+	/* Jobs in lanes and finished ones never outnumber the lanes, so there is a free one. */
+	while (mgr->lane[l] != NULL)
+	{
+		++l;
+	}
+	
+	mgr->lane[l] = job;
+	load(mgr->batch, (uint8_t *) mgr->state, mgr->lanes, l, job->ctx);
+	advance(mgr, l);
+	++mgr->active;
+	
+	if (mgr->finished == 0 && mgr->active == mgr->lanes)
+	{
+		while (mgr->finished == 0)
+		{
+			step(mgr);
+		}
+	}
+	
+	return mgr->finished > 0 ? mgr->done[--mgr->finished] : NULL;
+}
+
+struct ampheck_job *ampheck_mgr_flush(struct ampheck_mgr *mgr)
+{
+	if (mgr->finished == 0 && mgr->active > 0)
+	{
+		/* With most lanes idle, one stream at a time is faster. */
+		if (mgr->kernel->transform != NULL && mgr->active <= mgr->lanes / 4)
+		{
+			unsigned int l = 0;
+			
+			while (mgr->lane[l] == NULL)
+			{
+				++l;
+			}
+			
+			drain(mgr, l);
+		}
+		else
+		{
+			while (mgr->finished == 0)
+			{
+				step(mgr);
+			}
+		}
+	}
+	
+	return mgr->finished > 0 ? mgr->done[--mgr->finished] : NULL;
+}
+
+/*
+	The batch functions keep a pool of one job more than there are lanes: at
+	most that many are ever out at once, and each submit or flush that hands
+	one back frees it for the next context.
+*/
+
+#define POOL (AMPHECK_MGR_LANES + 1)
+
+void ampheck_batch_update(struct ampheck_batch *batch, void *ctx, const uint8_t *const data[], const size_t length[], size_t count)
+{
+	struct ampheck_mgr mgr;
+	struct ampheck_job jobs[POOL];
+	struct ampheck_job *spare[POOL];
+	unsigned int spares = 0;
+	
+	ampheck_mgr_init(&mgr, batch);
+	
+	for (unsigned int j = 0; j < POOL; ++j)
+	{
+		spare[spares++] = &jobs[j];
+	}
+	
+	for (size_t i = 0; i < count; ++i)
+	{
+		struct ampheck_job *job = spare[--spares];
+		
+		job->ctx = (uint8_t *) ctx + i * batch->size;
+		job->data = data[i];
+		job->length = length[i];
+		job->flags = 0;
+		
+		if ((job = ampheck_mgr_submit(&mgr, job)) != NULL)
+		{
+			spare[spares++] = job;
+		}
+	}
+	
+	while (ampheck_mgr_flush(&mgr) != NULL)
+	{
+	}
+}
+
+void ampheck_batch_finish(struct ampheck_batch *batch, const void *ctx, uint8_t *const digest[], size_t count)
+{
+	struct ampheck_mgr mgr;
+	struct ampheck_job jobs[POOL];
+	struct ampheck_job *spare[POOL];
+	uint8_t copies[POOL][256] __attribute__((aligned(8)));
+	unsigned int spares = 0;
+	
+	ampheck_mgr_init(&mgr, batch);
+	
+	for (unsigned int j = 0; j < POOL; ++j)
+	{
+		jobs[j].ctx = copies[j];
+		spare[spares++] = &jobs[j];
+	}
+	
+	/* The contexts are const, so each job finishes a copy of the parts that padding reads. */
+	for (size_t i = 0; i < count; ++i)
+	{
+		const uint8_t *c = (const uint8_t *) ctx + i * batch->size;
+		struct ampheck_job *job = spare[--spares];
+		uint8_t *copy = job->ctx;
+		uint64_t total;
+		
+		memcpy(&total, &c[batch->length], sizeof(total));
+		memcpy(copy, c, batch->words * batch->word);
+		memcpy(&copy[batch->buffer], &c[batch->buffer], total % batch->block);
+		memcpy(&copy[batch->length], &total, sizeof(total));
+		memcpy(&copy[batch->fill], &c[batch->fill], sizeof(uint32_t));
+		job->data = NULL;
+		job->length = 0;
+		job->flags = AMPHECK_JOB_LAST;
+		job->digest = digest[i];
+		
+		if ((job = ampheck_mgr_submit(&mgr, job)) != NULL)
+		{
+			spare[spares++] = job;
+		}
+	}
+	
+	while (ampheck_mgr_flush(&mgr) != NULL)
+	{
+	}
+}
@@ -0,0 +1,631 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+	Benchmark of the init/update/finish triples.
+	
+	For every algorithm, message size and update granularity (both swept in
+	powers of four), messages are hashed repeatedly for at least `time'
+	seconds.  Reported are throughput, cycles per byte and percentiles of
+	the per-message latency.  Cycles are TSC ticks on x86; elsewhere they
+	are not reported.
+	
+	With --one-shot messages go through ampheck_<algo>_digest() instead, and
+	the update column shows the message size.
+	
+	hash160 is measured composed, SHA-256 through init/update/finish and
+	then ampheck_ripemd160_digest() of its digest, and with --one-shot as a
+	single ampheck_hash160() call.
+	
+	With --counters (Linux only) each combination is run a second time under
+	perf_event_open counters, and IPC plus branch, L1D, L1I and LLC misses
+	and frontend stall cycles per compressed block are reported.  Counters
+	the host cannot provide are shown as missing.
+	
+	Usage: ampheck-bench [--json] [--counters] [--one-shot] [--algorithm=NAME[,NAME...]]
+	                     [--min-size=N] [--max-size=N]
+	                     [--min-granularity=N] [--max-granularity=N]
+	                     [--time=SECONDS]
+*/
+
+#define _POSIX_C_SOURCE 200112L
+#define _DEFAULT_SOURCE
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "backends.h"
+#include "hash160.h"
+#include "sha224.h"
+#include "sha384.h"
+#include "sha512_224.h"
+#include "sha512_256.h"
+
+#ifdef AMPHECK_X86
+#include <x86intrin.h>
+#define CYCLES() __rdtsc()
+#else
+#define CYCLES() 0
+#endif
+
+/* Updates never cross this window, so messages of any size reuse one buffer. */
+#define WINDOW (1 << 20)
+
+/* Combinations needing more update calls per message than this are skipped. */
+#define MAX_CALLS (1 << 24)
+
+#define MAX_SAMPLES 100000
+
+struct algorithm
+{
+	const char *name;
+	const char *family;
+	const struct ampheck_backend *backends;
+	unsigned int block;
+	void (*message)(const uint8_t *buffer, uint64_t size, size_t granularity, uint8_t *digest);
+	void (*oneshot)(const uint8_t *buffer, uint64_t size, size_t granularity, uint8_t *digest);
+};
+
+struct result
+{
+	uint64_t messages;
+	double seconds;
+	uint64_t cycles;
+	double p50, p90, p99;
+};
+
+enum
+{
+	COUNTER_CYCLES,
+	COUNTER_INSTRUCTIONS,
+	COUNTER_BRANCH_MISSES,
+	COUNTER_L1D_MISSES,
+	COUNTER_L1I_MISSES,
+	COUNTER_LLC_MISSES,
+	COUNTER_FRONTEND_STALLS,
+	COUNTERS
+};
+
+static const char *counter_names[COUNTERS] =
+{
+	"cycles", "instructions", "branch_misses", "l1d_misses", "l1i_misses", "llc_misses", "frontend_stalls"
+};
+
+/* File descriptors of the opened counters, -1 where unavailable. */
+static int counters[COUNTERS];
+
+/* Set by --one-shot. */
+static int one_shot = 0;
+
+#define MESSAGE(algo) \
+static void message_##algo(const uint8_t *buffer, uint64_t size, size_t granularity, uint8_t *digest) \
+{ \
+	struct ampheck_##algo ctx; \
+	uint64_t offset = 0; \
+	\
+	ampheck_##algo##_init(&ctx); \
+	\
+	while (offset < size) \
+	{ \
+		size_t length = size - offset < granularity ? (size_t) (size - offset) : granularity; \
+		\
+		ampheck_##algo##_update(&ctx, &buffer[offset % WINDOW], length); \
+		offset += length; \
+	} \
+	\
+	ampheck_##algo##_finish(&ctx, digest); \
+}
+
+/* Sizes are kept within the buffer in one-shot mode. */
+#define ONESHOT(algo) \
+static void oneshot_##algo(const uint8_t *buffer, uint64_t size, size_t granularity, uint8_t *digest) \
+{ \
+	(void) granularity; \
+	\
+	ampheck_##algo##_digest(buffer, (size_t) size, digest); \
+}
+
+MESSAGE(md4)
+MESSAGE(md5)
+MESSAGE(ripemd128)
+MESSAGE(ripemd160)
+MESSAGE(sha0)
+MESSAGE(sha1)
+MESSAGE(sha224)
+MESSAGE(sha256)
+MESSAGE(sha384)
+MESSAGE(sha512)
+MESSAGE(sha512_224)
+MESSAGE(sha512_256)
+
+ONESHOT(md4)
+ONESHOT(md5)
+ONESHOT(ripemd128)
+ONESHOT(ripemd160)
+ONESHOT(sha0)
+ONESHOT(sha1)
+ONESHOT(sha224)
+ONESHOT(sha256)
+ONESHOT(sha384)
+ONESHOT(sha512)
+ONESHOT(sha512_224)
+ONESHOT(sha512_256)
+
+static void message_hash160(const uint8_t *buffer, uint64_t size, size_t granularity, uint8_t *digest)
+{
+	uint8_t first[32];
+	
+	message_sha256(buffer, size, granularity, first);
+	ampheck_ripemd160_digest(first, sizeof(first), digest);
+}
+
+static void oneshot_hash160(const uint8_t *buffer, uint64_t size, size_t granularity, uint8_t *digest)
+{
+	(void) granularity;
+	
+	ampheck_hash160(buffer, (size_t) size, digest);
+}
+
+static const struct algorithm algorithms[] =
+{
+	{ "md4",       "md4",       ampheck_md4_backends,         64, message_md4,       oneshot_md4       },
+	{ "md5",       "md5",       ampheck_md5_backends,         64, message_md5,       oneshot_md5       },
+	{ "ripemd128", "ripemd128", ampheck_ripemd128_backends,   64, message_ripemd128, oneshot_ripemd128 },
+	{ "ripemd160", "ripemd160", ampheck_ripemd160_backends,   64, message_ripemd160, oneshot_ripemd160 },
+	{ "sha0",      "sha0",      ampheck_sha0_backends,        64, message_sha0,      oneshot_sha0      },
+	{ "sha1",      "sha1",      ampheck_sha1_backends,        64, message_sha1,      oneshot_sha1      },
+	{ "sha224",    "sha256",    ampheck_sha256_backends,      64, message_sha224,    oneshot_sha224    },
+	{ "sha256",    "sha256",    ampheck_sha256_backends,      64, message_sha256,    oneshot_sha256    },
+	{ "sha384",    "sha512",    ampheck_sha512_backends,     128, message_sha384,    oneshot_sha384    },
+	{ "sha512",    "sha512",    ampheck_sha512_backends,     128, message_sha512,    oneshot_sha512    },
+	{ "sha512_224", "sha512",   ampheck_sha512_backends,     128, message_sha512_224, oneshot_sha512_224 },
+	{ "sha512_256", "sha512",   ampheck_sha512_backends,     128, message_sha512_256, oneshot_sha512_256 },
+	{ "hash160",   "sha256",    ampheck_sha256_backends,      64, message_hash160,   oneshot_hash160   }
+};
+
+static double now(void)
+{
+	struct timespec ts;
+	
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+#ifdef __linux__
+static int counter_open(uint32_t type, uint64_t config)
+{
+	struct perf_event_attr attr;
+	
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = type;
+	attr.config = config;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	
+	return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+#define CACHE_MISS(cache) (PERF_COUNT_HW_CACHE_##cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+static int counters_open(void)
+{
+	int opened = 0;
+	
+	counters[COUNTER_CYCLES] = counter_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+	counters[COUNTER_INSTRUCTIONS] = counter_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+	counters[COUNTER_BRANCH_MISSES] = counter_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+	counters[COUNTER_L1D_MISSES] = counter_open(PERF_TYPE_HW_CACHE, CACHE_MISS(L1D));
+	counters[COUNTER_L1I_MISSES] = counter_open(PERF_TYPE_HW_CACHE, CACHE_MISS(L1I));
+	counters[COUNTER_LLC_MISSES] = counter_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+	counters[COUNTER_FRONTEND_STALLS] = counter_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_FRONTEND);
+	
+	for (int i = 0; i < COUNTERS; ++i)
+	{
+		opened += counters[i] >= 0;
+	}
+	
+	return opened;
+}
+
+/* Runs `messages' messages and stores each counter's value, scaled for multiplexing, or -1. */
+static void count(const struct algorithm *algorithm, const uint8_t *buffer, uint64_t size, size_t granularity, uint64_t messages, double *values)
+{
+	uint8_t digest[64];
+	
+	for (int i = 0; i < COUNTERS; ++i)
+	{
+		if (counters[i] >= 0)
+		{
+			ioctl(counters[i], PERF_EVENT_IOC_RESET, 0);
+			ioctl(counters[i], PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+	
+	for (uint64_t i = 0; i < messages; ++i)
+	{
+		(one_shot ? algorithm->oneshot : algorithm->message)(buffer, size, granularity, digest);
+	}
+	
+	for (int i = 0; i < COUNTERS; ++i)
+	{
+		uint64_t value[3];
+		
+		values[i] = -1;
+		
+		if (counters[i] < 0)
+		{
+			continue;
+		}
+		
+		ioctl(counters[i], PERF_EVENT_IOC_DISABLE, 0);
+		
+		if (read(counters[i], value, sizeof(value)) == sizeof(value) && value[2] != 0)
+		{
+			values[i] = (double) value[0] * value[1] / value[2];
+		}
+	}
+}
+#else
+static int counters_open(void)
+{
+	return 0;
+}
+
+static void count(const struct algorithm *algorithm, const uint8_t *buffer, uint64_t size, size_t granularity, uint64_t messages, double *values)
+{
+	(void) algorithm; (void) buffer; (void) size; (void) granularity; (void) messages;
+	
+	for (int i = 0; i < COUNTERS; ++i)
+	{
+		values[i] = -1;
+	}
+}
+#endif
+
+static int ascending(const void *a, const void *b)
+{
+	const uint64_t x = *(const uint64_t *) a;
+	const uint64_t y = *(const uint64_t *) b;
+	
+	return (x > y) - (x < y);
+}
+
+static int selected(const char *list, const char *name)
+{
+	size_t length = strlen(name);
+	
+	if (list == NULL)
+	{
+		return 1;
+	}
+	
+	while (*list != '\0')
+	{
+		size_t size = strcspn(list, ",");
+		
+		if (size == length && memcmp(list, name, length) == 0)
+		{
+			return 1;
+		}
+		
+		list += size;
+		list += *list == ',';
+	}
+	
+	return 0;
+}
+
+/* Latency samples are in TSC ticks on x86 and in nanoseconds elsewhere. */
+static void measure(const struct algorithm *algorithm, const uint8_t *buffer, uint64_t size, size_t granularity, double time, uint64_t *samples, struct result *result)
+{
+	uint8_t digest[64];
+	uint64_t count = 0;
+	double start = now();
+	uint64_t cycles = CYCLES();
+	double elapsed;
+	
+	do
+	{
+		uint64_t before = CYCLES();
+		double wall = now();
+		
+		(one_shot ? algorithm->oneshot : algorithm->message)(buffer, size, granularity, digest);
+		
+		if (count < MAX_SAMPLES)
+		{
+			samples[count] = CYCLES() - before;
+			
+			if (samples[count] == 0)
+			{
+				samples[count] = (uint64_t) ((now() - wall) * 1e9);
+			}
+		}
+		
+		++count;
+		elapsed = now() - start;
+	}
+	while (elapsed < time && count < 100 * (uint64_t) MAX_SAMPLES);
+	
+	result->messages = count;
+	result->seconds = elapsed;
+	result->cycles = CYCLES() - cycles;
+	
+	count = count < MAX_SAMPLES ? count : MAX_SAMPLES;
+	qsort(samples, count, sizeof(*samples), ascending);
+	
+	{
+		/* Converts samples to nanoseconds using the ticks seen over the whole run. */
+		double scale = result->cycles ? elapsed * 1e9 / result->cycles : 1.0;
+		
+		result->p50 = samples[count * 50 / 100] * scale;
+		result->p90 = samples[count * 90 / 100] * scale;
+		result->p99 = samples[count * 99 / 100] * scale;
+	}
+}
+
+static uint64_t option(const char *arg, const char *name, uint64_t value)
+{
+	size_t length = strlen(name);
+	
+	if (strncmp(arg, name, length) == 0 && arg[length] == '=')
+	{
+		return strtoull(&arg[length + 1], NULL, 0);
+	}
+	
+	return value;
+}
+
+int main(int argc, char *argv[])
+{
+	uint64_t min_size = 1, max_size = (uint64_t) 1 << 30;
+	uint64_t min_granularity = 1, max_granularity = WINDOW;
+	const char *names = NULL;
+	double time = 0.2;
+	int json = 0;
+	int events = 0;
+	int first = 1;
+	uint64_t *samples;
+	uint8_t *buffer;
+	
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--json") == 0)
+		{
+			json = 1;
+		}
+		else if (strcmp(argv[i], "--counters") == 0)
+		{
+			events = 1;
+		}
+		else if (strcmp(argv[i], "--one-shot") == 0)
+		{
+			one_shot = 1;
+		}
+		else if (strncmp(argv[i], "--algorithm=", 12) == 0)
+		{
+			names = &argv[i][12];
+		}
+		else if (strncmp(argv[i], "--time=", 7) == 0)
+		{
+			time = strtod(&argv[i][7], NULL);
+		}
+		else if (strncmp(argv[i], "--min-", 6) == 0 || strncmp(argv[i], "--max-", 6) == 0)
+		{
+			min_size = option(argv[i], "--min-size", min_size);
+			max_size = option(argv[i], "--max-size", max_size);
+			min_granularity = option(argv[i], "--min-granularity", min_granularity);
+			max_granularity = option(argv[i], "--max-granularity", max_granularity);
+		}
+		else
+		{
+			fprintf(stderr, "%s: unknown option `%s'\n", argv[0], argv[i]);
+			return 2;
+		}
+	}
+	
+	if (events && counters_open() == 0)
+	{
+		fprintf(stderr, "%s: no performance counters available\n", argv[0]);
+		return 2;
+	}
+	
+	if (max_granularity > WINDOW)
+	{
+		max_granularity = WINDOW;
+	}
+	
+	buffer = malloc(2 * WINDOW);
+	samples = malloc(MAX_SAMPLES * sizeof(*samples));
+	
+	if (buffer == NULL || samples == NULL)
+	{
+		perror("malloc");
+		return 2;
+	}
+	
+	for (size_t i = 0; i < 2 * WINDOW; ++i)
+	{
+		buffer[i] = (uint8_t) (i * 2654435761u >> 24);
+	}
+	
+	if (json)
+	{
+		printf("[\n");
+	}
+	else
+	{
+		printf("%-10s %-8s %11s %8s %10s %10s %12s %12s %12s", "algorithm", "backend", "size", "update", "MB/s", "cycles/B", "p50 ns", "p90 ns", "p99 ns");
+		
+		if (events)
+		{
+			printf(" %6s %9s %9s %9s %9s %9s", "IPC", "br/blk", "L1D/blk", "L1I/blk", "LLC/blk", "FE/blk");
+		}
+		
+		printf("\n");
+	}
+	
+	for (size_t a = 0; a < sizeof(algorithms) / sizeof(*algorithms); ++a)
+	{
+		const struct algorithm *algorithm = &algorithms[a];
+		const char *backend;
+		
+		if (!selected(names, algorithm->name))
+		{
+			continue;
+		}
+		
+		backend = ampheck_backend_select(algorithm->family, algorithm->backends)->name;
+		
+		for (uint64_t size = min_size; size <= max_size; size *= 4)
+		{
+			for (uint64_t granularity = min_granularity; granularity <= max_granularity; granularity *= 4)
+			{
+				struct result result;
+				double values[COUNTERS];
+				/* Compressed blocks per message, including the padding. */
+				double blocks = (double) ((size + algorithm->block / 8 + algorithm->block) / algorithm->block);
+				
+				if (granularity > size && granularity != min_granularity)
+				{
+					break;
+				}
+				
+				if (one_shot)
+				{
+					if (granularity != min_granularity || size > 2 * WINDOW)
+					{
+						break;
+					}
+					
+					granularity = size;
+				}
+				
+				if (size / granularity > MAX_CALLS)
+				{
+					continue;
+				}
+				
+				measure(algorithm, buffer, size, (size_t) granularity, time, samples, &result);
+				
+				if (events)
+				{
+					count(algorithm, buffer, size, (size_t) granularity, result.messages, values);
+					blocks *= result.messages;
+				}
+				
+				if (json)
+				{
+					printf("%s\t{ \"algorithm\": \"%s\", \"backend\": \"%s\", \"size\": %llu, \"granularity\": %llu, "
+					       "\"messages\": %llu, \"seconds\": %.6f, \"bytes_per_second\": %.1f, \"cycles_per_byte\": %.3f, "
+					       "\"latency_ns\": { \"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f }",
+					       first ? "" : ",\n", algorithm->name, backend,
+					       (unsigned long long) size, (unsigned long long) granularity, (unsigned long long) result.messages,
+					       result.seconds, size * result.messages / result.seconds,
+					       (double) result.cycles / (size * result.messages),
+					       result.p50, result.p90, result.p99);
+					
+					if (events)
+					{
+						printf(", \"blocks\": %.0f, \"ipc\": ", blocks);
+						
+						if (values[COUNTER_CYCLES] > 0 && values[COUNTER_INSTRUCTIONS] >= 0)
+						{
+							printf("%.3f", values[COUNTER_INSTRUCTIONS] / values[COUNTER_CYCLES]);
+						}
+						else
+						{
+							printf("null");
+						}
+						
+						printf(", \"per_block\": {");
+						
+						for (int i = 0; i < COUNTERS; ++i)
+						{
+							printf(values[i] < 0 ? "%s \"%s\": null" : "%s \"%s\": %.4f", i ? "," : "", counter_names[i], values[i] / blocks);
+						}
+						
+						printf(" }");
+					}
+					
+					printf(" }");
+				}
+				else
+				{
+					printf("%-10s %-8s %11llu %8llu %10.1f %10.3f %12.1f %12.1f %12.1f", algorithm->name, backend,
+					       (unsigned long long) size, (unsigned long long) granularity,
+					       size * result.messages / result.seconds / 1e6,
+					       (double) result.cycles / (size * result.messages),
+					       result.p50, result.p90, result.p99);
+					
+					if (events)
+					{
+						if (values[COUNTER_CYCLES] > 0 && values[COUNTER_INSTRUCTIONS] >= 0)
+						{
+							printf(" %6.2f", values[COUNTER_INSTRUCTIONS] / values[COUNTER_CYCLES]);
+						}
+						else
+						{
+							printf(" %6s", "-");
+						}
+						
+						for (int i = COUNTER_BRANCH_MISSES; i < COUNTERS; ++i)
+						{
+							if (values[i] < 0)
+							{
+								printf(" %9s", "-");
+							}
+							else
+							{
+								printf(" %9.3f", values[i] / blocks);
+							}
+						}
+					}
+					
+					printf("\n");
+				}
+				
+				first = 0;
+				fflush(stdout);
+			}
+		}
+	}
+	
+	if (json)
+	{
+		printf("\n]\n");
+	}
+	
+	free(samples);
+	free(buffer);
+	
+	return 0;
+}
@@ -0,0 +1,1009 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+	Differential conformance and throughput check for the transform backends.
+	
+	Every backend the CPU supports is run in its own child process, selected
+	through AMPHECK_BACKEND, so that the real init/update/finish path is the
+	one under test.  Digests are compared against a reference that pads the
+	message independently and runs the generic transform over it.  The batch
+	functions and the job manager are checked the same way for every
+	multi-buffer kernel.
+	
+	Usage: conformance [seed]
+*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "backends.h"
+#include "hash160.h"
+#include "sha224.h"
+#include "sha256d.h"
+#include "sha384.h"
+#include "sha512_224.h"
+#include "sha512_256.h"
+
+#ifdef AMPHECK_POOL
+#include "pool.h"
+#endif
+
+#define TRIALS 2000
+#define THROUGHPUT (8 << 20)
+#define BATCH 200
+#define IOV 16
+
+struct algorithm
+{
+	const char *name;
+	const char *family;
+	const struct ampheck_backend *backends;
+	size_t block;
+	size_t digest;
+	void (*reference)(const uint8_t *data, size_t size, uint8_t *digest);
+	void (*hash)(const uint8_t *data, size_t size, const size_t *splits, size_t count, uint8_t *digest);
+	void (*oneshot)(const uint8_t *data, size_t size, uint8_t *digest);
+	const char *abc;
+	const struct ampheck_lanes *lanes;
+	void (*batch)(const uint8_t *const data[], const size_t size[], const size_t cut[], size_t count, uint8_t *const digest[]);
+	void (*mgr)(const uint8_t *const data[], const size_t size[], const size_t cut[], size_t count, uint8_t *const digest[]);
+};
+
+/* Functions built on an algorithm's kernels, checked once per kernel against the reference. */
+struct derived
+{
+	const char *name;
+	const char *family;
+	const struct ampheck_lanes *lanes;
+	int (*check)(const uint8_t *data);
+};
+
+static uint64_t state = 0x9e3779b97f4a7c15ULL;
+
+static uint64_t rnd(void)
+{
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+	
+	return state;
+}
+
+/* Builds the padded message; `length' is the size of the length field. */
+static uint8_t *pad(const uint8_t *data, size_t size, size_t block, size_t length, int big_endian, size_t *blocks)
+{
+	uint8_t *buffer;
+	
+	*blocks = (size + 1 + length + block - 1) / block;
+	buffer = calloc(*blocks, block);
+	
+	if (buffer == NULL)
+	{
+		perror("calloc");
+		exit(2);
+	}
+	
+	memcpy(buffer, data, size);
+	buffer[size] = 0x80;
+	
+	for (size_t i = 0; i < 8; ++i)
+	{
+		uint8_t byte = (uint8_t) (((uint64_t) size * 8) >> (i * 8));
+		
+		if (big_endian)
+		{
+			buffer[*blocks * block - 1 - i] = byte;
+		}
+		else
+		{
+			buffer[*blocks * block - length + i] = byte;
+		}
+	}
+	
+	return buffer;
+}
+
+static void serialize(const void *h, size_t word, size_t size, int big_endian, uint8_t *digest)
+{
+	for (size_t i = 0; i < size; ++i)
+	{
+		uint64_t value = word == 8 ? ((const uint64_t *) h)[i / 8] : ((const uint32_t *) h)[i / 4];
+		size_t shift = big_endian ? (word - 1 - i % word) * 8 : (i % word) * 8;
+		
+		digest[i] = (uint8_t) (value >> shift);
+	}
+}
+
+/* The chaining values lead every context, so the IV is copied from the start of `init'. */
+#define REFERENCE(algo, base, block, length, big_endian, size) \
+static void reference_##algo(const uint8_t *data, size_t len, uint8_t *digest) \
+{ \
+	struct ampheck_##algo init; \
+	struct ampheck_##base ctx; \
+	size_t blocks; \
+	uint8_t *buffer = pad(data, len, block, length, big_endian, &blocks); \
+	\
+	ampheck_##algo##_init(&init); \
+	memcpy(ctx.h, &init, sizeof(ctx.h)); \
+	ampheck_##base##_transform_generic(&ctx, buffer, blocks); \
+	serialize(ctx.h, sizeof(ctx.h[0]), size, big_endian, digest); \
+	\
+	free(buffer); \
+}
+
+/*
+	Odd split counts finish in place, so both finishes are checked, and
+	split counts of 2 or 3 modulo 4 hand the pieces over as iovecs, up to
+	IOV at a time.
+*/
+#define HASH(algo) \
+static void hash_##algo(const uint8_t *data, size_t size, const size_t *splits, size_t count, uint8_t *digest) \
+{ \
+	struct ampheck_##algo ctx; \
+	struct iovec iov[IOV]; \
+	size_t offset = 0; \
+	int pieces = 0; \
+	\
+	ampheck_##algo##_init(&ctx); \
+	\
+	for (size_t i = 0; i <= count; ++i) \
+	{ \
+		size_t end = i < count ? splits[i] : size; \
+		\
+		if (count % 4 < 2) \
+		{ \
+			ampheck_##algo##_update(&ctx, &data[offset], end - offset); \
+		} \
+		else \
+		{ \
+			iov[pieces].iov_base = (void *) &data[offset]; \
+			iov[pieces++].iov_len = end - offset; \
+			\
+			if (pieces == IOV || i == count) \
+			{ \
+				ampheck_##algo##_updatev(&ctx, iov, pieces); \
+				pieces = 0; \
+			} \
+		} \
+		\
+		offset = end; \
+	} \
+	\
+	if (count % 2) \
+	{ \
+		ampheck_##algo##_finish_inplace(&ctx, digest); \
+	} \
+	else \
+	{ \
+		ampheck_##algo##_finish(&ctx, digest); \
+	} \
+}
+
+/* Hashes `count' messages with two batch updates each, split at `cut'. */
+#define BATCH_HASH(algo) \
+static void batch_##algo(const uint8_t *const data[], const size_t size[], const size_t cut[], size_t count, uint8_t *const digest[]) \
+{ \
+	struct ampheck_##algo ctx[BATCH]; \
+	const uint8_t *tail[BATCH]; \
+	size_t rest[BATCH]; \
+	\
+	for (size_t i = 0; i < count; ++i) \
+	{ \
+		tail[i] = &data[i][cut[i]]; \
+		rest[i] = size[i] - cut[i]; \
+	} \
+	\
+	ampheck_##algo##_init_batch(ctx, count); \
+	ampheck_##algo##_update_batch(ctx, data, cut, count); \
+	ampheck_##algo##_update_batch(ctx, tail, rest, count); \
+	ampheck_##algo##_finish_batch(ctx, digest, count); \
+}
+
+/* The same through a job manager: the second job of a message goes in once its first is handed back. */
+static void submit_jobs(struct ampheck_mgr *mgr, struct ampheck_job *jobs, const uint8_t *const data[], const size_t size[], const size_t cut[], size_t count, uint8_t *const digest[])
+{
+	struct ampheck_job *job;
+	size_t next = 0;
+	
+	for (;;)
+	{
+		if (next < count)
+		{
+			job = &jobs[next];
+			job->data = data[next];
+			job->length = cut[next];
+			job->flags = AMPHECK_JOB_FIRST;
+			job->digest = digest[next];
+			
+			job = ampheck_mgr_submit(mgr, &jobs[next++]);
+		}
+		else if ((job = ampheck_mgr_flush(mgr)) == NULL)
+		{
+			break;
+		}
+		
+		while (job != NULL && !(job->flags & AMPHECK_JOB_LAST))
+		{
+			size_t i = (size_t) (job - jobs);
+			
+			job->data = &data[i][cut[i]];
+			job->length = size[i] - cut[i];
+			job->flags = AMPHECK_JOB_LAST;
+			
+			job = ampheck_mgr_submit(mgr, job);
+		}
+	}
+}
+
+#define MGR_HASH(algo) \
+static void mgr_##algo(const uint8_t *const data[], const size_t size[], const size_t cut[], size_t count, uint8_t *const digest[]) \
+{ \
+	struct ampheck_##algo ctx[BATCH]; \
+	struct ampheck_job jobs[BATCH]; \
+	struct ampheck_mgr mgr; \
+	\
+	for (size_t i = 0; i < count; ++i) \
+	{ \
+		jobs[i].ctx = &ctx[i]; \
+	} \
+	\
+	ampheck_##algo##_mgr_init(&mgr); \
+	submit_jobs(&mgr, jobs, data, size, cut, count, digest); \
+}
+
+REFERENCE(md4,       md4,        64,  8, 0, 16)
+REFERENCE(md5,       md5,        64,  8, 0, 16)
+REFERENCE(ripemd128, ripemd128,  64,  8, 0, 16)
+REFERENCE(ripemd160, ripemd160,  64,  8, 0, 20)
+REFERENCE(sha0,      sha0,       64,  8, 1, 20)
+REFERENCE(sha1,      sha1,       64,  8, 1, 20)
+REFERENCE(sha224,    sha256,     64,  8, 1, 28)
+REFERENCE(sha256,    sha256,     64,  8, 1, 32)
+REFERENCE(sha384,    sha512,    128, 16, 1, 48)
+REFERENCE(sha512,    sha512,    128, 16, 1, 64)
+REFERENCE(sha512_224, sha512,   128, 16, 1, 28)
+REFERENCE(sha512_256, sha512,   128, 16, 1, 32)
+
+HASH(md4)
+HASH(md5)
+HASH(ripemd128)
+HASH(ripemd160)
+HASH(sha0)
+HASH(sha1)
+HASH(sha224)
+HASH(sha256)
+HASH(sha384)
+HASH(sha512)
+HASH(sha512_224)
+HASH(sha512_256)
+
+BATCH_HASH(md4)
+BATCH_HASH(md5)
+BATCH_HASH(ripemd160)
+BATCH_HASH(sha1)
+BATCH_HASH(sha256)
+BATCH_HASH(sha384)
+BATCH_HASH(sha512)
+BATCH_HASH(sha512_224)
+BATCH_HASH(sha512_256)
+
+MGR_HASH(md4)
+MGR_HASH(md5)
+MGR_HASH(ripemd160)
+MGR_HASH(sha1)
+MGR_HASH(sha256)
+MGR_HASH(sha384)
+MGR_HASH(sha512)
+MGR_HASH(sha512_224)
+MGR_HASH(sha512_256)
+
+static const struct algorithm algorithms[] =
+{
+	{ "md4",       "md4",       ampheck_md4_backends,        64, 16, reference_md4,       hash_md4, ampheck_md4_digest,
+	  "a448017aaf21d8525fc10ae87aa6729d", ampheck_md4_lanes, batch_md4, mgr_md4 },
+	{ "md5",       "md5",       ampheck_md5_backends,        64, 16, reference_md5,       hash_md5, ampheck_md5_digest,
+	  "900150983cd24fb0d6963f7d28e17f72", ampheck_md5_lanes, batch_md5, mgr_md5 },
+	{ "ripemd128", "ripemd128", ampheck_ripemd128_backends,  64, 16, reference_ripemd128, hash_ripemd128, ampheck_ripemd128_digest,
+	  "c14a12199c66e4ba84636b0f69144c77", NULL, NULL, NULL },
+	{ "ripemd160", "ripemd160", ampheck_ripemd160_backends,  64, 20, reference_ripemd160, hash_ripemd160, ampheck_ripemd160_digest,
+	  "8eb208f7e05d987a9b044a8e98c6b087f15a0bfc", ampheck_ripemd160_lanes, batch_ripemd160, mgr_ripemd160 },
+	{ "sha0",      "sha0",      ampheck_sha0_backends,       64, 20, reference_sha0,      hash_sha0, ampheck_sha0_digest,
+	  "0164b8a914cd2a5e74c4f7ff082c4d97f1edf880", NULL, NULL, NULL },
+	{ "sha1",      "sha1",      ampheck_sha1_backends,       64, 20, reference_sha1,      hash_sha1, ampheck_sha1_digest,
+	  "a9993e364706816aba3e25717850c26c9cd0d89d", ampheck_sha1_lanes, batch_sha1, mgr_sha1 },
+	{ "sha224",    "sha256",    ampheck_sha256_backends,     64, 28, reference_sha224,    hash_sha224, ampheck_sha224_digest,
+	  "23097d223405d8228642a477bda255b32aadbce4bda0b3f7e36c9da7", NULL, NULL, NULL },
+	{ "sha256",    "sha256",    ampheck_sha256_backends,     64, 32, reference_sha256,    hash_sha256, ampheck_sha256_digest,
+	  "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+	  ampheck_sha256_lanes, batch_sha256, mgr_sha256 },
+	{ "sha384",    "sha512",    ampheck_sha512_backends,    128, 48, reference_sha384,    hash_sha384, ampheck_sha384_digest,
+	  "cb00753f45a35e8bb5a03d699ac65007272c32ab0eded1631a8b605a43ff5bed"
+	  "8086072ba1e7cc2358baeca134c825a7", ampheck_sha512_lanes, batch_sha384, mgr_sha384 },
+	{ "sha512",    "sha512",    ampheck_sha512_backends,    128, 64, reference_sha512,    hash_sha512, ampheck_sha512_digest,
+	  "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"
+	  "2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f", ampheck_sha512_lanes, batch_sha512, mgr_sha512 },
+	{ "sha512_224", "sha512",   ampheck_sha512_backends,    128, 28, reference_sha512_224, hash_sha512_224, ampheck_sha512_224_digest,
+	  "4634270f707b6a54daae7530460842e20e37ed265ceee9a43e8924aa", ampheck_sha512_lanes, batch_sha512_224, mgr_sha512_224 },
+	{ "sha512_256", "sha512",   ampheck_sha512_backends,    128, 32, reference_sha512_256, hash_sha512_256, ampheck_sha512_256_digest,
+	  "53048e2681941ef99b2e29b76b4c7dabe4c2d0c634fc6d46e0e2f13107e7af23", ampheck_sha512_lanes, batch_sha512_256, mgr_sha512_256 }
+};
+
+/*
+	Checks a function of the SHA-256 digest, `outer' of it, against the
+	reference: every length up to three blocks one at a time, then `fixed'
+	and random lengths in batches.
+*/
+static int check_composed(const char *name, void (*single)(const uint8_t *, size_t, uint8_t *),
+                          void (*batch)(const uint8_t *const [], size_t, uint8_t *const [], size_t),
+                          void (*outer)(const uint8_t *, size_t, uint8_t *), size_t size, const size_t fixed[2], const uint8_t *data)
+{
+	const uint8_t *messages[BATCH];
+	uint8_t digests[BATCH][32];
+	uint8_t *digest[BATCH];
+	uint8_t expected[32];
+	
+	for (size_t length = 0; length <= 3 * 64; ++length)
+	{
+		reference_sha256(data, length, expected);
+		outer(expected, 32, expected);
+		single(data, length, digests[0]);
+		
+		if (memcmp(expected, digests[0], size) != 0)
+		{
+			fprintf(stderr, "%s: mismatch at length %lu\n", name, (unsigned long) length);
+			
+			return 1;
+		}
+	}
+	
+	for (size_t i = 0; i < BATCH; ++i)
+	{
+		digest[i] = digests[i];
+	}
+	
+	for (size_t trial = 0; trial < TRIALS / 10; ++trial)
+	{
+		size_t length = trial % 4 < 2 ? fixed[trial % 4] : rnd() % (4 * 64);
+		size_t count = 1 + rnd() % BATCH;
+		
+		for (size_t i = 0; i < count; ++i)
+		{
+			messages[i] = &data[rnd() % (THROUGHPUT / 2)];
+		}
+		
+		batch(messages, length, digest, count);
+		
+		for (size_t i = 0; i < count; ++i)
+		{
+			reference_sha256(messages[i], length, expected);
+			outer(expected, 32, expected);
+			
+			if (memcmp(expected, digests[i], size) != 0)
+			{
+				fprintf(stderr, "%s: batch mismatch at length %lu (message %lu of %lu)\n", name,
+				        (unsigned long) length, (unsigned long) i, (unsigned long) count);
+				
+				return 1;
+			}
+		}
+	}
+	
+	return 0;
+}
+
+static int check_sha256d(const uint8_t *data)
+{
+	static const size_t fixed[2] = { 32, 80 };
+	
+	return check_composed("sha256d", ampheck_sha256d, ampheck_sha256d_batch, reference_sha256, 32, fixed, data);
+}
+
+static int check_hash160(const uint8_t *data)
+{
+	static const size_t fixed[2] = { 33, 65 };
+	
+	return check_composed("hash160", ampheck_hash160, ampheck_hash160_batch, reference_ripemd160, 20, fixed, data);
+}
+
+/* Scans a random header against an easy target, so that about one nonce in 256 matches, and checks every nonce one by one. */
+static int check_scan(const uint8_t *data)
+{
+	static const uint32_t first[3] = { 0, 0x12345677, 0xFFFFF000 };
+	uint32_t found[4096];
+	uint8_t target[32];
+	uint8_t header[80];
+	
+	for (size_t trial = 0; trial < 3; ++trial)
+	{
+		const uint32_t last = first[trial] + 4095;
+		size_t max = trial == 1 ? 5 : 4096;
+		size_t matches;
+		size_t next = 0;
+		
+		memcpy(header, &data[rnd() % (THROUGHPUT / 2)], sizeof(header));
+		memset(target, 0xFF, sizeof(target));
+		target[31] = 0x00;
+		
+		matches = ampheck_sha256d_scan(header, first[trial], last, target, found, max);
+		
+		for (uint32_t nonce = first[trial]; next < max; ++nonce)
+		{
+			uint8_t expected[32];
+			int match = 1;
+			
+			for (size_t i = 0; i < 4; ++i)
+			{
+				header[76 + i] = (uint8_t) (nonce >> (i * 8));
+			}
+			
+			reference_sha256(header, 80, expected);
+			reference_sha256(expected, 32, expected);
+			
+			for (int i = 31; i >= 0; --i)
+			{
+				if (expected[i] != target[i])
+				{
+					match = expected[i] < target[i];
+					break;
+				}
+			}
+			
+			if (match)
+			{
+				if (next >= matches || found[next] != nonce)
+				{
+					fprintf(stderr, "sha256d scan: missed nonce %08lx\n", (unsigned long) nonce);
+					
+					return 1;
+				}
+				
+				++next;
+			}
+			
+			if (nonce == last)
+			{
+				break;
+			}
+		}
+		
+		if (next != matches)
+		{
+			fprintf(stderr, "sha256d scan: %lu nonces found, %lu expected\n", (unsigned long) matches, (unsigned long) next);
+			
+			return 1;
+		}
+	}
+	
+	return 0;
+}
+
+static const struct derived derived[] =
+{
+	{ "sha256d", "sha256", ampheck_sha256_lanes, check_sha256d },
+	{ "hash160", "ripemd160", ampheck_ripemd160_lanes, check_hash160 },
+	{ "scan",    "sha256",    ampheck_sha256d_scan_lanes, check_scan }
+};
+
+static int compare(const struct algorithm *algorithm, const uint8_t *data, size_t size, const size_t *splits, size_t count)
+{
+	uint8_t expected[64];
+	uint8_t actual[64];
+	
+	algorithm->reference(data, size, expected);
+	algorithm->hash(data, size, splits, count, actual);
+	
+	if (memcmp(expected, actual, algorithm->digest) != 0)
+	{
+		fprintf(stderr, "%s: mismatch at length %lu with %lu updates\n", algorithm->name, (unsigned long) size, (unsigned long) count + 1);
+		
+		return 1;
+	}
+	
+	if (count == 0)
+	{
+		algorithm->oneshot(data, size, actual);
+		
+		if (memcmp(expected, actual, algorithm->digest) != 0)
+		{
+			fprintf(stderr, "%s: one-shot mismatch at length %lu\n", algorithm->name, (unsigned long) size);
+			
+			return 1;
+		}
+	}
+	
+	return 0;
+}
+
+/*
+	One million bytes of `i % 251', hashed in a single update, so that the
+	known answers also go through long runs of blocks in one transform call.
+	Unlike a million times 'a', no two neighbouring blocks are equal, so a
+	kernel stepping through the input with the wrong stride is caught. The
+	digests were produced with an independent implementation.
+*/
+static const struct
+{
+	const char *name;
+	const char *digest;
+} million[] =
+{
+	{ "md5",        "35efddb2811ce9ecbdfa17f18472e604" },
+	{ "ripemd160",  "9326a84417fc68a8cc0e00288941e6c4b768b8a3" },
+	{ "sha1",       "1f7cafedffb2797c60013e6f95d7763bbc57c1ee" },
+	{ "sha224",     "644a4c0306841f1c47d7e9d43740667b95f68242f6d7fd22e36624a9" },
+	{ "sha256",     "2c030d49ec131bfbbb446ad21e7a2f12cdb4f2f4f3fda3ac709dd2e68a4646c7" },
+	{ "sha384",     "6617ea3f5ceba4043c9543ff4210a9440a2f1f3a61d2f0d37bcc9beb5f65ba17"
+	                "ac25a71738d8d900899785c4859ad52e" },
+	{ "sha512",     "c64684a6d351bdb7e7e050d30d61ca838044c888d7a488142cc0001e56e86e8f"
+	                "aec7ab8588dfa82243fecd146da30cce2625c494b1d0c2633fb044c3a2f9a0af" },
+	{ "sha512_224", "3b670d3f51c6eedd29234b1221c856d47ac7f5e91253c5e53c2969da" },
+	{ "sha512_256", "e8b431d24afae0c58229ac4232fb31ce776362415ca3b97b72a3a61366cdb0f7" }
+};
+
+static int digest_is(const struct algorithm *algorithm, const uint8_t *data, size_t size, const char *expected)
+{
+	uint8_t digest[64];
+	char hex[129];
+	
+	algorithm->hash(data, size, NULL, 0, digest);
+	
+	for (size_t i = 0; i < algorithm->digest; ++i)
+	{
+		sprintf(&hex[i * 2], "%02x", digest[i]);
+	}
+	
+	return strcmp(hex, expected) == 0;
+}
+
+static int known_answer(const struct algorithm *algorithm)
+{
+	if (!digest_is(algorithm, (const uint8_t *) "abc", 3, algorithm->abc))
+	{
+		fprintf(stderr, "%s: wrong digest of \"abc\"\n", algorithm->name);
+		
+		return 1;
+	}
+	
+	for (size_t i = 0; i < sizeof(million) / sizeof(*million); ++i)
+	{
+		if (strcmp(million[i].name, algorithm->name) == 0)
+		{
+			uint8_t *data = malloc(1000000);
+			int ok;
+			
+			if (data == NULL)
+			{
+				perror("malloc");
+				exit(2);
+			}
+			
+			for (size_t j = 0; j < 1000000; ++j)
+			{
+				data[j] = j % 251;
+			}
+			
+			ok = digest_is(algorithm, data, 1000000, million[i].digest);
+			free(data);
+			
+			if (!ok)
+			{
+				fprintf(stderr, "%s: wrong digest of a million bytes\n", algorithm->name);
+				
+				return 1;
+			}
+		}
+	}
+	
+	return 0;
+}
+
+static int conformance(const struct algorithm *algorithm, uint8_t *data)
+{
+	const size_t block = algorithm->block;
+	size_t splits[16];
+	int failures = known_answer(algorithm);
+	
+	/* Every length around the padding thresholds, in one update and byte by byte. */
+	for (size_t size = 0; size <= 3 * block && failures == 0; ++size)
+	{
+		size_t bytes[3 * 128];
+		
+		for (size_t i = 0; i < size; ++i)
+		{
+			bytes[i] = i + 1;
+		}
+		
+		failures += compare(algorithm, data, size, NULL, 0);
+		failures += compare(algorithm, data, size, bytes, size > 0 ? size - 1 : 0);
+	}
+	
+	/* Random lengths, cut at random points. */
+	for (size_t trial = 0; trial < TRIALS && failures == 0; ++trial)
+	{
+		size_t size = rnd() % 4 ? rnd() % (8 * block) : rnd() % (1 << 16);
+		size_t count = size > 0 ? rnd() % 16 : 0;
+		
+		for (size_t i = 0; i < count; ++i)
+		{
+			splits[i] = rnd() % (size + 1);
+		}
+		
+		for (size_t i = 1; i < count; ++i)
+		{
+			for (size_t j = i; j > 0 && splits[j - 1] > splits[j]; --j)
+			{
+				size_t tmp = splits[j];
+				
+				splits[j] = splits[j - 1];
+				splits[j - 1] = tmp;
+			}
+		}
+		
+		failures += compare(algorithm, data, size, splits, count);
+	}
+	
+	return failures;
+}
+
+static int batch_conformance(const struct algorithm *algorithm, const uint8_t *data)
+{
+	const uint8_t *messages[BATCH];
+	uint8_t digests[BATCH][64];
+	uint8_t *digest[BATCH];
+	size_t size[BATCH];
+	size_t cut[BATCH];
+	
+	for (size_t i = 0; i < BATCH; ++i)
+	{
+		digest[i] = digests[i];
+	}
+	
+	for (size_t trial = 0; trial < TRIALS / 10; ++trial)
+	{
+		size_t count = 1 + rnd() % BATCH;
+		
+		for (size_t i = 0; i < count; ++i)
+		{
+			messages[i] = &data[rnd() % (THROUGHPUT / 2)];
+			size[i] = rnd() % 8 ? rnd() % (4 * algorithm->block) : rnd() % (1 << 14);
+			cut[i] = rnd() % 2 ? rnd() % (size[i] + 1) : size[i];
+		}
+		
+		/* Odd trials go through the job manager. */
+		if (trial % 2)
+		{
+			algorithm->mgr(messages, size, cut, count, digest);
+		}
+		else
+		{
+			algorithm->batch(messages, size, cut, count, digest);
+		}
+		
+		for (size_t i = 0; i < count; ++i)
+		{
+			uint8_t expected[64];
+			
+			algorithm->reference(messages[i], size[i], expected);
+			
+			if (memcmp(expected, digests[i], algorithm->digest) != 0)
+			{
+				fprintf(stderr, "%s: %s mismatch at length %lu (message %lu of %lu)\n", algorithm->name, trial % 2 ? "job" : "batch",
+				        (unsigned long) size[i], (unsigned long) i, (unsigned long) count);
+				
+				return 1;
+			}
+		}
+	}
+	
+	return 0;
+}
+
+/* Hashes the data as 1 KiB messages, BATCH at a time. */
+static double batch_throughput(const struct algorithm *algorithm, const uint8_t *data)
+{
+	struct timespec start, end;
+	const uint8_t *messages[BATCH];
+	uint8_t digests[BATCH][64];
+	uint8_t *digest[BATCH];
+	size_t size[BATCH];
+	double elapsed;
+	
+	for (size_t i = 0; i < BATCH; ++i)
+	{
+		digest[i] = digests[i];
+		size[i] = 1024;
+	}
+	
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	
+	for (size_t offset = 0; offset + BATCH * 1024 <= THROUGHPUT; offset += BATCH * 1024)
+	{
+		for (size_t i = 0; i < BATCH; ++i)
+		{
+			messages[i] = &data[offset + i * 1024];
+		}
+		
+		algorithm->batch(messages, size, size, BATCH, digest);
+	}
+	
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	
+	elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	
+	return elapsed > 0 ? (THROUGHPUT / (BATCH * 1024)) * (BATCH * 1024) / elapsed : 0;
+}
+
+static double throughput(const struct algorithm *algorithm, const uint8_t *data)
+{
+	struct timespec start, end;
+	size_t splits[THROUGHPUT >> 16];
+	uint8_t digest[64];
+	double elapsed;
+	
+	for (size_t i = 0; i < THROUGHPUT >> 16; ++i)
+	{
+		splits[i] = i << 16;
+	}
+	
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	algorithm->hash(data, THROUGHPUT, &splits[1], (THROUGHPUT >> 16) - 1, digest);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	
+	elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	
+	return elapsed > 0 ? THROUGHPUT / elapsed : 0;
+}
+
+static int run(const struct algorithm *algorithm, const struct ampheck_backend *backend, uint8_t *data)
+{
+	char selection[64];
+	int failures;
+	
+	snprintf(selection, sizeof(selection), "%s=%s", algorithm->family, backend->name);
+	setenv("AMPHECK_BACKEND", selection, 1);
+	
+	failures = conformance(algorithm, data);
+	
+	printf("%-10s %-8s %-4s %10.1f MB/s\n", algorithm->name, backend->name, failures ? "FAIL" : "ok", throughput(algorithm, data) / 1e6);
+	fflush(stdout);
+	
+	return failures != 0;
+}
+
+static int run_batch(const struct algorithm *algorithm, const struct ampheck_lanes *kernel, uint8_t *data)
+{
+	char selection[64];
+	int failures;
+	
+	snprintf(selection, sizeof(selection), "%s=%s", algorithm->family, kernel->name);
+	setenv("AMPHECK_BACKEND", selection, 1);
+	
+	failures = batch_conformance(algorithm, data);
+	
+	printf("%-10s %-8s %-4s %10.1f MB/s in %u lane%s\n", algorithm->name, kernel->name, failures ? "FAIL" : "ok",
+	       batch_throughput(algorithm, data) / 1e6, kernel->lanes, kernel->lanes > 1 ? "s" : "");
+	fflush(stdout);
+	
+	return failures != 0;
+}
+
+static int run_derived(const struct derived *derived, const struct ampheck_lanes *kernel, uint8_t *data)
+{
+	char selection[64];
+	int failures;
+	
+	snprintf(selection, sizeof(selection), "%s=%s", derived->family, kernel->name);
+	setenv("AMPHECK_BACKEND", selection, 1);
+	
+	failures = derived->check(data);
+	
+	printf("%-10s %-8s %-4s in %u lane%s\n", derived->name, kernel->name, failures ? "FAIL" : "ok",
+	       kernel->lanes, kernel->lanes > 1 ? "s" : "");
+	fflush(stdout);
+	
+	return failures != 0;
+}
+
+#ifdef AMPHECK_POOL
+static void pool_done(struct ampheck_pool_job *job)
+{
+	job->user = job;
+}
+
+/* Hashes BATCH messages of every algorithm, a few of them long and the first one from a file, on four workers. */
+static int pool_conformance(const uint8_t *data)
+{
+	const size_t count = sizeof(algorithms) / sizeof(*algorithms);
+	struct ampheck_pool_job jobs[BATCH];
+	uint8_t digests[BATCH][64];
+	struct ampheck_pool *pool = ampheck_pool_new(4);
+	FILE *file = tmpfile();
+	int failures = 0;
+	
+	if (pool == NULL || file == NULL)
+	{
+		perror("pool");
+		exit(2);
+	}
+	
+	for (size_t i = 0; i < BATCH; ++i)
+	{
+		jobs[i].algorithm = algorithms[i % count].name;
+		jobs[i].data = &data[rnd() % (THROUGHPUT / 2)];
+		jobs[i].length = rnd() % 16 ? rnd() % (1 << 14) : rnd() % (THROUGHPUT / 2);
+		jobs[i].fd = -1;
+		jobs[i].digest = digests[i];
+		jobs[i].done = pool_done;
+		jobs[i].event = -1;
+		jobs[i].user = NULL;
+	}
+	
+	if (fwrite(jobs[0].data, 1, jobs[0].length, file) != jobs[0].length || fflush(file) != 0)
+	{
+		perror("tmpfile");
+		exit(2);
+	}
+	
+	rewind(file);
+	jobs[0].fd = fileno(file);
+	
+	for (size_t i = 0; i < BATCH; ++i)
+	{
+		if (ampheck_pool_submit(pool, &jobs[i]) != 0)
+		{
+			fprintf(stderr, "pool: %s rejected\n", jobs[i].algorithm);
+			failures = 1;
+		}
+	}
+	
+	ampheck_pool_wait(pool);
+	
+	for (size_t i = 0; i < BATCH && failures == 0; ++i)
+	{
+		uint8_t expected[64];
+		
+		algorithms[i % count].reference(jobs[i].data, jobs[i].length, expected);
+		
+		if (jobs[i].user != &jobs[i] || jobs[i].error != 0 || memcmp(expected, digests[i], algorithms[i % count].digest) != 0)
+		{
+			fprintf(stderr, "pool: %s mismatch at length %lu (job %lu)\n", jobs[i].algorithm,
+			        (unsigned long) jobs[i].length, (unsigned long) i);
+			
+			failures = 1;
+		}
+	}
+	
+	ampheck_pool_free(pool);
+	fclose(file);
+	
+	printf("%-10s %-8s %-4s on 4 workers\n", "all", "pool", failures ? "FAIL" : "ok");
+	
+	return failures;
+}
+#endif
+
+/* Runs one backend or kernel, of an algorithm or of a derived function, in a child process so that its selection stays there. */
+static int spawn(const struct algorithm *algorithm, const struct derived *derived, const struct ampheck_backend *backend, const struct ampheck_lanes *kernel, uint8_t *data)
+{
+	pid_t pid;
+	int status;
+	
+	fflush(stdout);
+	pid = fork();
+	
+	if (pid < 0)
+	{
+		perror("fork");
+		exit(2);
+	}
+	
+	if (pid == 0)
+	{
+		if (derived != NULL)
+		{
+			_exit(run_derived(derived, kernel, data));
+		}
+		
+		_exit(backend != NULL ? run(algorithm, backend, data) : run_batch(algorithm, kernel, data));
+	}
+	
+	return waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+}
+
+int main(int argc, char *argv[])
+{
+	const unsigned int features = ampheck_cpu_features();
+	int failures = 0;
+	uint8_t *data;
+	
+	if (argc > 1)
+	{
+		state = strtoull(argv[1], NULL, 0) | 1;
+	}
+	
+	data = malloc(THROUGHPUT);
+	
+	if (data == NULL)
+	{
+		perror("malloc");
+		return 2;
+	}
+	
+	for (size_t i = 0; i < THROUGHPUT; ++i)
+	{
+		data[i] = (uint8_t) rnd();
+	}
+	
+	for (size_t i = 0; i < sizeof(algorithms) / sizeof(*algorithms); ++i)
+	{
+		for (const struct ampheck_backend *backend = algorithms[i].backends; backend->name != NULL; ++backend)
+		{
+			if ((backend->features & features) != backend->features)
+			{
+				printf("%-10s %-8s skip\n", algorithms[i].name, backend->name);
+				continue;
+			}
+			
+			failures += spawn(&algorithms[i], NULL, backend, NULL, data);
+		}
+		
+		for (const struct ampheck_lanes *kernel = algorithms[i].lanes; kernel != NULL && kernel->name != NULL; ++kernel)
+		{
+			if ((kernel->features & features) != kernel->features)
+			{
+				printf("%-10s %-8s skip\n", algorithms[i].name, kernel->name);
+				continue;
+			}
+			
+			failures += spawn(&algorithms[i], NULL, NULL, kernel, data);
+		}
+	}
+	
+	for (size_t i = 0; i < sizeof(derived) / sizeof(*derived); ++i)
+	{
+		for (const struct ampheck_lanes *kernel = derived[i].lanes; kernel->name != NULL; ++kernel)
+		{
+			if ((kernel->features & features) != kernel->features)
+			{
+				printf("%-10s %-8s skip\n", derived[i].name, kernel->name);
+				continue;
+			}
+			
+			failures += spawn(NULL, &derived[i], NULL, kernel, data);
+		}
+	}
+	
+#ifdef AMPHECK_POOL
+	failures += pool_conformance(data);
+#endif
+	
+	free(data);
+	
+	return failures != 0;
+}
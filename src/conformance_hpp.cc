@@ -0,0 +1,169 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*
+	Checks ampheck.hpp: known answers evaluated at compile time, and the
+	header's rounds, fixed-length overloads and RAII types against the C
+	functions at run time.
+*/
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "ampheck.hpp"
+
+template <typename Digest>
+constexpr bool matches(const Digest &digest, std::string_view hex)
+{
+	constexpr std::string_view digits = "0123456789abcdef";
+	
+	if (hex.size() != 2 * digest.size())
+	{
+		return false;
+	}
+	
+	for (std::size_t i = 0; i < digest.size(); ++i)
+	{
+		if (digits[digest[i] >> 4] != hex[2 * i] || digits[digest[i] & 0x0F] != hex[2 * i + 1])
+		{
+			return false;
+		}
+	}
+	
+	return true;
+}
+
+static_assert(matches(ampheck::md4::digest("abc"), "a448017aaf21d8525fc10ae87aa6729d"));
+static_assert(matches(ampheck::md5::digest("abc"), "900150983cd24fb0d6963f7d28e17f72"));
+static_assert(matches(ampheck::sha224::digest("abc"), "23097d223405d8228642a477bda255b32aadbce4bda0b3f7e36c9da7"));
+static_assert(matches(ampheck::sha256::digest("abc"), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"));
+static_assert(matches(ampheck::sha384::digest("abc"),
+                      "cb00753f45a35e8bb5a03d699ac65007272c32ab0eded1631a8b605a43ff5bed8086072ba1e7cc2358baeca134c825a7"));
+static_assert(matches(ampheck::sha512::digest("abc"),
+                      "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"
+                      "2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f"));
+static_assert(matches(ampheck::sha512_224::digest("abc"), "4634270f707b6a54daae7530460842e20e37ed265ceee9a43e8924aa"));
+static_assert(matches(ampheck::sha512_256::digest("abc"), "53048e2681941ef99b2e29b76b4c7dabe4c2d0c634fc6d46e0e2f13107e7af23"));
+
+/* A message longer than a SHA-512 block, so that constant evaluation goes through whole blocks too. */
+static_assert(ampheck::sha256::digest(std::string_view("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"
+                                                       "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"
+                                                       "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"))
+           != ampheck::sha256::digest_type{});
+
+/* The fixed-length overloads in a constant expression. */
+static_assert(ampheck::sha256::digest(std::array<std::uint8_t, 3>{ 'a', 'b', 'c' }) == ampheck::sha256::digest("abc"));
+static_assert(ampheck::md5::digest(std::array<std::uint8_t, 3>{ 'a', 'b', 'c' }) == ampheck::md5::digest("abc"));
+
+static std::uint64_t state = 0x9e3779b97f4a7c15ULL;
+
+static std::uint8_t rnd()
+{
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+	
+	return static_cast<std::uint8_t>(state);
+}
+
+template <std::size_t N, typename Hash>
+static bool fixed(const std::vector<std::uint8_t> &data)
+{
+	std::array<std::uint8_t, N> input;
+	
+	std::memcpy(input.data(), data.data(), N);
+	
+	return Hash::digest(input) == Hash::digest(std::span<const std::uint8_t>(data.data(), N))
+	    && Hash::digest(std::span<const std::uint8_t, N>(input)) == Hash::digest(input);
+}
+
+template <typename Hash, bool Rounds>
+static int check(const char *name, const std::vector<std::uint8_t> &data)
+{
+	int failures = 0;
+	
+	for (std::size_t size = 0; size <= 3 * 128 && failures == 0; ++size)
+	{
+		const std::span<const std::uint8_t> message(data.data(), size);
+		const auto expected = Hash::digest(message);
+		Hash hash;
+		
+		/* Two updates, then a move, then the rest; finishing the rvalue resets it. */
+		hash.update(message.first(size / 3)).update(message.subspan(size / 3, size / 3));
+		
+		Hash moved(std::move(hash));
+		
+		moved.update(message.subspan(2 * (size / 3)));
+		
+		if (moved.finish() != expected || std::move(moved).finish() != expected
+		    || moved.finish() != Hash::digest(std::span<const std::uint8_t>()) || hash.finish() != Hash::digest(std::span<const std::uint8_t>()))
+		{
+			std::fprintf(stderr, "%s: RAII mismatch at length %lu\n", name, static_cast<unsigned long>(size));
+			++failures;
+		}
+		
+		if constexpr (Rounds)
+		{
+			if (ampheck::detail::run<typename Hash::traits_type>(data.data(), size) != expected)
+			{
+				std::fprintf(stderr, "%s: header rounds mismatch at length %lu\n", name, static_cast<unsigned long>(size));
+				++failures;
+			}
+		}
+	}
+	
+	if (!fixed<16, Hash>(data) || !fixed<20, Hash>(data) || !fixed<32, Hash>(data) || !fixed<64, Hash>(data))
+	{
+		std::fprintf(stderr, "%s: fixed-length mismatch\n", name);
+		++failures;
+	}
+	
+	std::printf("%-10s %-8s %s\n", name, "c++", failures ? "FAIL" : "ok");
+	
+	return failures;
+}
+
+int main()
+{
+	std::vector<std::uint8_t> data(3 * 128);
+	int failures = 0;
+	
+	for (auto &byte : data)
+	{
+		byte = rnd();
+	}
+	
+	failures += check<ampheck::md4, true>("md4", data);
+	failures += check<ampheck::md5, true>("md5", data);
+	failures += check<ampheck::ripemd128, false>("ripemd128", data);
+	failures += check<ampheck::ripemd160, false>("ripemd160", data);
+	failures += check<ampheck::sha0, false>("sha0", data);
+	failures += check<ampheck::sha1, false>("sha1", data);
+	failures += check<ampheck::sha224, true>("sha224", data);
+	failures += check<ampheck::sha256, true>("sha256", data);
+	failures += check<ampheck::sha384, true>("sha384", data);
+	failures += check<ampheck::sha512, true>("sha512", data);
+	failures += check<ampheck::sha512_224, true>("sha512_224", data);
+	failures += check<ampheck::sha512_256, true>("sha512_256", data);
+	
+	return failures != 0;
+}
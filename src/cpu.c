@@ -0,0 +1,123 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cpu.h"
+
+#ifdef AMPHECK_X86
+#include <cpuid.h>
+
+static uint64_t xgetbv(uint32_t index)
+{
+	uint32_t eax, edx;
+	
+	__asm__ __volatile__ ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (index));
+	
+	return ((uint64_t) edx << 32) | eax;
+}
+
+static unsigned int detect(void)
+{
+	unsigned int eax, ebx, ecx, edx;
+	unsigned int features = 0;
+	uint64_t xcr0 = 0;
+	
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+	{
+		return 0;
+	}
+	
+	if (ecx & bit_SSSE3)
+	{
+		features |= AMPHECK_CPU_SSSE3;
+	}
+	
+	if (ecx & bit_SSE4_1)
+	{
+		features |= AMPHECK_CPU_SSE41;
+	}
+	
+	/* The YMM and ZMM registers are only usable if the OS saves them. */
+	if (ecx & bit_OSXSAVE)
+	{
+		xcr0 = xgetbv(0);
+	}
+	
+	if ((ecx & bit_AVX) && (xcr0 & 0x06) == 0x06)
+	{
+		features |= AMPHECK_CPU_AVX;
+	}
+	
+	if (__get_cpuid_max(0, NULL) < 7)
+	{
+		return features;
+	}
+	
+	__cpuid_count(7, 0, eax, ebx, ecx, edx);
+	
+	if ((ebx & bit_AVX2) && (features & AMPHECK_CPU_AVX))
+	{
+		features |= AMPHECK_CPU_AVX2;
+	}
+	
+	if (ebx & bit_BMI2)
+	{
+		features |= AMPHECK_CPU_BMI2;
+	}
+	
+	if (ebx & bit_SHA)
+	{
+		features |= AMPHECK_CPU_SHA;
+	}
+	
+	if ((ebx & bit_AVX512F) && (xcr0 & 0xE6) == 0xE6)
+	{
+		features |= AMPHECK_CPU_AVX512F;
+		
+		if (ebx & bit_AVX512VL)
+		{
+			features |= AMPHECK_CPU_AVX512VL;
+		}
+	}
+	
+	return features;
+}
+#else
+static unsigned int detect(void)
+{
+	return 0;
+}
+#endif
+
+/* Set in the cached word once detect() has run, so that it needs no flag of its own. */
+#define DETECTED 0x80000000u
+
+unsigned int ampheck_cpu_features(void)
+{
+	static unsigned int features = 0;
+	unsigned int cached = AMPHECK_LOAD(features);
+	
+	if (cached == 0)
+	{
+		cached = detect() | DETECTED;
+		AMPHECK_STORE(features, cached);
+	}
+	
+	return cached & ~DETECTED;
+}
@@ -0,0 +1,51 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ampheck_cpu_h
+#define ampheck_cpu_h
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AMPHECK_X86 1
+#endif
+
+#define AMPHECK_CPU_SSSE3    0x0001
+#define AMPHECK_CPU_SSE41    0x0002
+#define AMPHECK_CPU_AVX      0x0004
+#define AMPHECK_CPU_AVX2     0x0008
+#define AMPHECK_CPU_BMI2     0x0010
+#define AMPHECK_CPU_SHA      0x0020
+#define AMPHECK_CPU_AVX512F  0x0040
+#define AMPHECK_CPU_AVX512VL 0x0080
+
+unsigned int ampheck_cpu_features(void);
+
+/*
+	The CPU features and the backends picked from them are cached on first
+	use, which may be in several threads at once.  Each cache is one word
+	read with AMPHECK_LOAD and written with AMPHECK_STORE, so a thread sees
+	either nothing yet, and selects the same thing itself, or a finished
+	selection.  Compilers without the GNU atomics get plain accesses.
+*/
+#ifdef __GNUC__
+#define AMPHECK_LOAD(x) __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define AMPHECK_STORE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+#else
+#define AMPHECK_LOAD(x) (x)
+#define AMPHECK_STORE(x, v) ((x) = (v))
+#endif
+
+#endif
@@ -0,0 +1,131 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "backends.h"
+#include "cpu.h"
+
+/*
+	AMPHECK_BACKEND is a comma separated list of backend names, either bare
+	("generic") to apply to every algorithm that has such a backend, or
+	qualified ("sha256=avx2") to apply to one algorithm.  A qualified entry
+	wins over a bare one.  Backends the CPU cannot run are ignored.
+*/
+static int forced(const char *algorithm, const char **name, size_t *length)
+{
+	const char *env = getenv("AMPHECK_BACKEND");
+	int found = 0;
+	
+	if (env == NULL)
+	{
+		return 0;
+	}
+	
+	while (*env != '\0')
+	{
+		size_t size = strcspn(env, ",");
+		const char *value = memchr(env, '=', size);
+		
+		if (value == NULL)
+		{
+			if (!found)
+			{
+				*name = env;
+				*length = size;
+				found = 1;
+			}
+		}
+		else if ((size_t) (value - env) == strlen(algorithm) && memcmp(env, algorithm, value - env) == 0)
+		{
+			*name = value + 1;
+			*length = size - (value - env) - 1;
+			
+			return 1;
+		}
+		
+		env += size;
+		
+		if (*env == ',')
+		{
+			++env;
+		}
+	}
+	
+	return found;
+}
+
+const struct ampheck_backend *ampheck_backend_select(const char *algorithm, const struct ampheck_backend *backends)
+{
+	const unsigned int features = ampheck_cpu_features();
+	const char *name = NULL;
+	size_t length = 0;
+	
+	if (forced(algorithm, &name, &length))
+	{
+		for (const struct ampheck_backend *backend = backends; backend->name != NULL; ++backend)
+		{
+			if (strlen(backend->name) == length && memcmp(backend->name, name, length) == 0
+			 && (backend->features & features) == backend->features)
+			{
+				return backend;
+			}
+		}
+	}
+	
+	for (const struct ampheck_backend *backend = backends; backend->name != NULL; ++backend)
+	{
+		if ((backend->features & features) == backend->features)
+		{
+			return backend;
+		}
+	}
+	
+	return NULL;
+}
+
+const struct ampheck_lanes *ampheck_lanes_select(const char *algorithm, const struct ampheck_lanes *lanes)
+{
+	const unsigned int features = ampheck_cpu_features();
+	const char *name = NULL;
+	size_t length = 0;
+	
+	if (forced(algorithm, &name, &length))
+	{
+		for (const struct ampheck_lanes *kernel = lanes; kernel->name != NULL; ++kernel)
+		{
+			if (strlen(kernel->name) == length && memcmp(kernel->name, name, length) == 0
+			 && (kernel->features & features) == kernel->features)
+			{
+				return kernel;
+			}
+		}
+	}
+	
+	for (const struct ampheck_lanes *kernel = lanes; kernel->name != NULL; ++kernel)
+	{
+		if ((kernel->features & features) == kernel->features)
+		{
+			return kernel;
+		}
+	}
+	
+	return NULL;
+}
@@ -0,0 +1,141 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "ampheck.h"
+#include "backends.h"
+#include "hash160.h"
+#include "ripemd160.h"
+
+/* The RIPEMD-160 block after the 32-byte SHA-256 digest: the padding of a 256-bit message, length little endian. */
+static const uint8_t hash160_pad[32] =
+{
+	0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+static const uint32_t hash160_iv[5] =
+{
+	0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0
+};
+
+/* The RIPEMD-160 of one block, through the single-stream transform. */
+static void hash160_block(const uint8_t *block, uint8_t *digest)
+{
+	struct ampheck_ripemd160 ctx;
+	
+	memcpy(ctx.h, hash160_iv, sizeof(ctx.h));
+	ampheck_ripemd160_transform(&ctx, block, 1);
+	
+	for (int j = 0; j < 5; ++j)
+	{
+		UNPACK_32_LE(ctx.h[j], &digest[j * 4]);
+	}
+}
+
+/* A single message goes through the single-stream SHA-256 transform; the lanes would only compress copies of it. */
+void ampheck_hash160(const uint8_t *data, size_t length, uint8_t *digest)
+{
+	uint8_t block[64];
+	
+	ampheck_sha256_single(data, length, block);
+	memcpy(&block[32], hash160_pad, sizeof(hash160_pad));
+	
+	hash160_block(block, digest);
+}
+
+/*
+	Compresses the RIPEMD-160 blocks, `count' at most AMPHECK_MGR_LANES, in
+	the lanes of the RIPEMD-160 kernel, or one at a time when most of the
+	lanes would be idle.
+*/
+static void hash160_second(uint8_t block[][64], size_t count, uint8_t *const digest[])
+{
+	static const struct ampheck_lanes *cached = NULL;
+	const struct ampheck_lanes *kernel = AMPHECK_LOAD(cached);
+	uint32_t state[5 * AMPHECK_MGR_LANES];
+	const uint8_t *rows[AMPHECK_MGR_LANES];
+	unsigned int lanes;
+	
+	if (kernel == NULL)
+	{
+		kernel = ampheck_lanes_select("ripemd160", ampheck_ripemd160_lanes);
+		AMPHECK_STORE(cached, kernel);
+	}
+	
+	lanes = kernel->lanes;
+	
+	for (size_t i = 0; i < count; i += lanes)
+	{
+		const size_t group = count - i < lanes ? count - i : lanes;
+		
+		if (kernel->transform == NULL || group <= lanes / 4)
+		{
+			for (size_t l = 0; l < group; ++l)
+			{
+				hash160_block(block[i + l], digest[i + l]);
+			}
+			
+			continue;
+		}
+		
+		for (unsigned int l = 0; l < lanes; ++l)
+		{
+			rows[l] = block[i + (l < group ? l : 0)];
+			
+			for (unsigned int j = 0; j < 5; ++j)
+			{
+				state[j * lanes + l] = hash160_iv[j];
+			}
+		}
+		
+		kernel->transform(state, rows, 1);
+		
+		for (size_t l = 0; l < group; ++l)
+		{
+			for (unsigned int j = 0; j < 5; ++j)
+			{
+				UNPACK_32_LE(state[j * lanes + l], &digest[i + l][j * 4]);
+			}
+		}
+	}
+}
+
+/* The SHA-256 lanes write their digests straight into the RIPEMD-160 blocks, whose padding is set up once. */
+void ampheck_hash160_batch(const uint8_t *const data[], size_t length, uint8_t *const digest[], size_t count)
+{
+	uint8_t block[AMPHECK_MGR_LANES][64];
+	uint8_t *first[AMPHECK_MGR_LANES];
+	
+	for (unsigned int l = 0; l < AMPHECK_MGR_LANES; ++l)
+	{
+		memcpy(&block[l][32], hash160_pad, sizeof(hash160_pad));
+		first[l] = block[l];
+	}
+	
+	for (size_t i = 0; i < count; i += AMPHECK_MGR_LANES)
+	{
+		const size_t group = count - i < AMPHECK_MGR_LANES ? count - i : AMPHECK_MGR_LANES;
+		
+		ampheck_sha256_fixed(&data[i], length, first, group);
+		hash160_second(block, group, &digest[i]);
+	}
+}
@@ -0,0 +1,37 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ampheck_hash160_h
+#define ampheck_hash160_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+	HASH160, RIPEMD-160 of the SHA-256 digest, of `length' bytes of `data',
+	without a context.  The SHA-256 digest is written straight into the one
+	RIPEMD-160 block, whose padding is fixed in advance.  Public keys of 33
+	and 65 bytes take one and two SHA-256 blocks.
+
+	The batch version hashes `count' messages of the same `length' side by
+	side in SIMD lanes where the CPU allows it.
+*/
+void ampheck_hash160(const uint8_t *data, size_t length, uint8_t *digest);
+void ampheck_hash160_batch(const uint8_t *const data[], size_t length, uint8_t *const digest[], size_t count);
+
+#endif
@@ -0,0 +1,153 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ampheck_lanes_h
+#define ampheck_lanes_h
+
+#include "cpu.h"
+
+#ifdef AMPHECK_X86
+
+#include <immintrin.h>
+
+/*
+	Multi-buffer kernels load one block row per message and transpose them
+	so that each vector holds the same message word of every lane.
+*/
+
+/* Transposes eight rows of eight 32-bit words. */
+__attribute__((target("avx2"), always_inline))
+static inline void ampheck_transpose8(__m256i *r)
+{
+	__m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+	__m256i t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+	__m256i t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+	__m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+	__m256i t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+	__m256i t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+	__m256i t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+	__m256i t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+	__m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+	__m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+	__m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+	__m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+	__m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+	__m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+	__m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+	__m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+	
+	r[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+	r[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+	r[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+	r[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+	r[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+	r[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+	r[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+	r[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+/* Transposes sixteen rows of sixteen 32-bit words. */
+__attribute__((target("avx512f"), always_inline))
+static inline void ampheck_transpose16(__m512i *r)
+{
+	__m512i t[16], u[16];
+	
+	for (int j = 0; j < 16; j += 2)
+	{
+		t[j    ] = _mm512_unpacklo_epi32(r[j], r[j + 1]);
+		t[j + 1] = _mm512_unpackhi_epi32(r[j], r[j + 1]);
+	}
+	
+	for (int j = 0; j < 16; j += 4)
+	{
+		u[j    ] = _mm512_unpacklo_epi64(t[j    ], t[j + 2]);
+		u[j + 1] = _mm512_unpackhi_epi64(t[j    ], t[j + 2]);
+		u[j + 2] = _mm512_unpacklo_epi64(t[j + 1], t[j + 3]);
+		u[j + 3] = _mm512_unpackhi_epi64(t[j + 1], t[j + 3]);
+	}
+	
+	for (int j = 0; j < 4; ++j)
+	{
+		__m512i v0 = _mm512_shuffle_i32x4(u[j    ], u[j +  4], 0x44);
+		__m512i v1 = _mm512_shuffle_i32x4(u[j    ], u[j +  4], 0xEE);
+		__m512i v2 = _mm512_shuffle_i32x4(u[j + 8], u[j + 12], 0x44);
+		__m512i v3 = _mm512_shuffle_i32x4(u[j + 8], u[j + 12], 0xEE);
+		
+		r[j     ] = _mm512_shuffle_i32x4(v0, v2, 0x88);
+		r[j +  4] = _mm512_shuffle_i32x4(v0, v2, 0xDD);
+		r[j +  8] = _mm512_shuffle_i32x4(v1, v3, 0x88);
+		r[j + 12] = _mm512_shuffle_i32x4(v1, v3, 0xDD);
+	}
+}
+
+/* Transposes four rows of four 64-bit words. */
+__attribute__((target("avx2"), always_inline))
+static inline void ampheck_transpose4_64(__m256i *r)
+{
+	__m256i t0 = _mm256_unpacklo_epi64(r[0], r[1]);
+	__m256i t1 = _mm256_unpackhi_epi64(r[0], r[1]);
+	__m256i t2 = _mm256_unpacklo_epi64(r[2], r[3]);
+	__m256i t3 = _mm256_unpackhi_epi64(r[2], r[3]);
+	
+	r[0] = _mm256_permute2x128_si256(t0, t2, 0x20);
+	r[1] = _mm256_permute2x128_si256(t1, t3, 0x20);
+	r[2] = _mm256_permute2x128_si256(t0, t2, 0x31);
+	r[3] = _mm256_permute2x128_si256(t1, t3, 0x31);
+}
+
+/* Transposes eight rows of eight 64-bit words. */
+__attribute__((target("avx512f"), always_inline))
+static inline void ampheck_transpose8_64(__m512i *r)
+{
+	__m512i t[8];
+	
+	for (int j = 0; j < 8; j += 2)
+	{
+		t[j    ] = _mm512_unpacklo_epi64(r[j], r[j + 1]);
+		t[j + 1] = _mm512_unpackhi_epi64(r[j], r[j + 1]);
+	}
+	
+	for (int j = 0; j < 2; ++j)
+	{
+		__m512i v0 = _mm512_shuffle_i64x2(t[j    ], t[j + 2], 0x44);
+		__m512i v1 = _mm512_shuffle_i64x2(t[j    ], t[j + 2], 0xEE);
+		__m512i v2 = _mm512_shuffle_i64x2(t[j + 4], t[j + 6], 0x44);
+		__m512i v3 = _mm512_shuffle_i64x2(t[j + 4], t[j + 6], 0xEE);
+		
+		r[j    ] = _mm512_shuffle_i64x2(v0, v2, 0x88);
+		r[j + 2] = _mm512_shuffle_i64x2(v0, v2, 0xDD);
+		r[j + 4] = _mm512_shuffle_i64x2(v1, v3, 0x88);
+		r[j + 6] = _mm512_shuffle_i64x2(v1, v3, 0xDD);
+	}
+}
+
+/* Swaps the byte order of each 32-bit word; byte shuffles on 512-bit vectors would need AVX-512BW. */
+__attribute__((target("avx512f"), always_inline))
+static inline __m512i ampheck_bswap32_avx512(__m512i x)
+{
+	return _mm512_ternarylogic_epi32(_mm512_ror_epi32(x, 8), _mm512_rol_epi32(x, 8), _mm512_set1_epi32((int) 0xFF00FF00), 0xE4);
+}
+
+__attribute__((target("avx512f"), always_inline))
+static inline __m512i ampheck_bswap64_avx512(__m512i x)
+{
+	return _mm512_ror_epi64(ampheck_bswap32_avx512(x), 32);
+}
+
+#endif
+
+#endif
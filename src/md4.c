@@ -19,7 +19,10 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <sys/uio.h>
+
 #include "ampheck.h"
+#include "backends.h"
 #include "md4.h"
 
 #define MD4_R1(x, y, z) (z ^ (x & (y ^ z)))
@@ -39,9 +42,10 @@ void ampheck_md4_init(struct ampheck_md4 *ctx)
 	ctx->h[3] = 0x10325476;
 	
 	ctx->length = 0;
+	ctx->fill = 0;
 }
 
-void ampheck_md4_transform(struct ampheck_md4 *ctx, const uint8_t *data, size_t blocks)
+void ampheck_md4_transform_generic(struct ampheck_md4 *ctx, const uint8_t *data, size_t blocks)
 {
 	for (size_t i = 0; i < blocks; ++i)
 	{
@@ -128,59 +132,179 @@ void ampheck_md4_transform(struct ampheck_md4 *ctx, const uint8_t *data, size_t
 	}
 }
 
-void ampheck_md4_update(struct ampheck_md4 *ctx, const uint8_t *data, size_t size)
+const struct ampheck_backend ampheck_md4_backends[] =
 {
-	size_t tmp = size;
+	{ "generic", 0, (ampheck_backend_fn) ampheck_md4_transform_generic },
+	{ NULL, 0, NULL }
+};
+
+void ampheck_md4_transform(struct ampheck_md4 *ctx, const uint8_t *data, size_t blocks)
+{
+	static void (*transform)(struct ampheck_md4 *, const uint8_t *, size_t) = NULL;
+	void (*selected)(struct ampheck_md4 *, const uint8_t *, size_t) = AMPHECK_LOAD(transform);
 	
-	if (size >= 64 - ctx->length % 64)
+	if (selected == NULL)
 	{
-		memcpy(&ctx->buffer[ctx->length % 64], data, 64 - ctx->length % 64);
+		selected = (void (*)(struct ampheck_md4 *, const uint8_t *, size_t)) ampheck_backend_select("md4", ampheck_md4_backends)->transform;
+		AMPHECK_STORE(transform, selected);
+	}
+	
+	selected(ctx, data, blocks);
+}
+
+const struct ampheck_lanes ampheck_md4_lanes[] =
+{
+#ifdef AMPHECK_X86
+	{ "avx512", AMPHECK_CPU_AVX512F, 16, ampheck_md4_lanes_avx512 },
+	{ "avx2", AMPHECK_CPU_AVX2, 8, ampheck_md4_lanes_avx2 },
+#endif
+	{ "generic", 0, 1, NULL },
+	{ NULL, 0, 0, NULL }
+};
+
+static void md4_batch_transform(void *h, const uint8_t *data, size_t blocks)
+{
+	struct ampheck_md4 ctx;
+	
+	memcpy(ctx.h, h, sizeof(ctx.h));
+	ampheck_md4_transform(&ctx, data, blocks);
+	memcpy(h, ctx.h, sizeof(ctx.h));
+}
+
+static void md4_batch_init(void *ctx)
+{
+	ampheck_md4_init(ctx);
+}
+
+static struct ampheck_batch md4_batch =
+{
+	"md4", ampheck_md4_lanes, NULL, md4_batch_transform, md4_batch_init,
+	sizeof(struct ampheck_md4), offsetof(struct ampheck_md4, buffer),
+	offsetof(struct ampheck_md4, length), offsetof(struct ampheck_md4, fill),
+	4, 4, 64, 16, 0
+};
+
+static void __attribute__((noinline)) md4_update_blocks(struct ampheck_md4 *ctx, const uint8_t *data, size_t size)
+{
+	if (ctx->fill > 0)
+	{
+		memcpy(&ctx->buffer[ctx->fill], data, 64 - ctx->fill);
 		
-		data += 64 - ctx->length % 64;
-		size -= 64 - ctx->length % 64;
+		data += 64 - ctx->fill;
+		size -= 64 - ctx->fill;
 		
 		ampheck_md4_transform(ctx, ctx->buffer, 1);
-		ampheck_md4_transform(ctx, data, size / 64);
-		
-		data += size & ~63;
-		size %= 64;
+	}
+	
+	ampheck_md4_transform(ctx, data, size / 64);
+	
+	data += size & ~(size_t) 63;
+	ctx->fill = (uint32_t) (size % 64);
+	
+	memcpy(ctx->buffer, data, ctx->fill);
+}
+
+void ampheck_md4_update(struct ampheck_md4 *ctx, const uint8_t *data, size_t size)
+{
+	ctx->length += size;
+	
+	if (size < 64 - ctx->fill)
+	{
+		uint8_t *p = &ctx->buffer[ctx->fill];
 		
-		memcpy(ctx->buffer, data, size);
+		ctx->fill += (uint32_t) size;
+		memcpy(p, data, size);
 	}
 	else
 	{
-		memcpy(&ctx->buffer[ctx->length % 64], data, size);
+		md4_update_blocks(ctx, data, size);
+	}
+}
+
+void ampheck_md4_updatev(struct ampheck_md4 *ctx, const struct iovec *iov, int iovcnt)
+{
+	for (int i = 0; i < iovcnt; ++i)
+	{
+		ampheck_md4_update(ctx, iov[i].iov_base, iov[i].iov_len);
 	}
-	
-	ctx->length += tmp;
 }
 
 void ampheck_md4_finish(const struct ampheck_md4 *ctx, uint8_t *digest)
 {
 	struct ampheck_md4 tmp;
 	
-	memcpy(tmp.h, ctx->h, 4 * sizeof(uint32_t));
-	memcpy(tmp.buffer, ctx->buffer, ctx->length % 64);
+	memcpy(tmp.h, ctx->h, sizeof(tmp.h));
+	memcpy(tmp.buffer, ctx->buffer, ctx->fill);
+	tmp.length = ctx->length;
+	tmp.fill = ctx->fill;
 	
-	tmp.buffer[ctx->length % 64] = 0x80;
+	ampheck_md4_finish_inplace(&tmp, digest);
+}
+
+void ampheck_md4_finish_inplace(struct ampheck_md4 *ctx, uint8_t *digest)
+{
+	ctx->buffer[ctx->fill] = 0x80;
 	
-	if (ctx->length % 64 < 56)
+	if (ctx->fill < 56)
 	{
-		memset(&tmp.buffer[ctx->length % 64 + 1], 0x00, 55 - ctx->length % 64);
+		memset(&ctx->buffer[ctx->fill + 1], 0x00, 55 - ctx->fill);
 	}
 	else
 	{
-		memset(&tmp.buffer[ctx->length % 64 + 1], 0x00, 63 - ctx->length % 64);
-		ampheck_md4_transform(&tmp, tmp.buffer, 1);
+		memset(&ctx->buffer[ctx->fill + 1], 0x00, 63 - ctx->fill);
+		ampheck_md4_transform(ctx, ctx->buffer, 1);
 		
-		memset(tmp.buffer, 0x00, 56);
+		memset(ctx->buffer, 0x00, 56);
+	}
+	
+	UNPACK_64_LE(ctx->length * 8, &ctx->buffer[56]);
+	ampheck_md4_transform(ctx, ctx->buffer, 1);
+	
+	UNPACK_32_LE(ctx->h[0], &digest[ 0]);
+	UNPACK_32_LE(ctx->h[1], &digest[ 4]);
+	UNPACK_32_LE(ctx->h[2], &digest[ 8]);
+	UNPACK_32_LE(ctx->h[3], &digest[12]);
+}
+
+void ampheck_md4_digest(const uint8_t *data, size_t length, uint8_t *digest)
+{
+	struct ampheck_md4 ctx;
+	uint8_t final[128];
+	
+	ampheck_md4_init(&ctx);
+	
+	if (length >= 64)
+	{
+		ampheck_md4_transform(&ctx, data, length / 64);
 	}
 	
-	UNPACK_64_LE(ctx->length * 8, &tmp.buffer[56]);
-	ampheck_md4_transform(&tmp, tmp.buffer, 1);
+	ampheck_md4_transform(&ctx, final, ampheck_final(final, &data[length & ~(size_t) 63], length, 64, 0));
 	
-	UNPACK_32_LE(tmp.h[0], &digest[ 0]);
-	UNPACK_32_LE(tmp.h[1], &digest[ 4]);
-	UNPACK_32_LE(tmp.h[2], &digest[ 8]);
-	UNPACK_32_LE(tmp.h[3], &digest[12]);
+	for (int j = 0; j < 4; ++j)
+	{
+		UNPACK_32_LE(ctx.h[j], &digest[j * 4]);
+	}
+}
+
+void ampheck_md4_init_batch(struct ampheck_md4 *ctx, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		ampheck_md4_init(&ctx[i]);
+	}
+}
+
+void ampheck_md4_update_batch(struct ampheck_md4 *ctx, const uint8_t *const data[], const size_t length[], size_t count)
+{
+	ampheck_batch_update(&md4_batch, ctx, data, length, count);
+}
+
+void ampheck_md4_finish_batch(const struct ampheck_md4 *ctx, uint8_t *const digest[], size_t count)
+{
+	ampheck_batch_finish(&md4_batch, ctx, digest, count);
+}
+
+void ampheck_md4_mgr_init(struct ampheck_mgr *mgr)
+{
+	ampheck_mgr_init(mgr, &md4_batch);
 }
@@ -21,16 +21,31 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "align.h"
+#include "mgr.h"
+
+struct iovec;
+
 struct ampheck_md5
 {
 	uint32_t h[4];
-	uint8_t buffer[64];
-	
 	uint64_t length;
+	uint32_t fill;
+	
+	AMPHECK_ALIGNED(64) uint8_t buffer[64];
 };
 
 void ampheck_md5_init(struct ampheck_md5 *ctx);
 void ampheck_md5_update(struct ampheck_md5 *ctx, const uint8_t *data, size_t length);
+void ampheck_md5_updatev(struct ampheck_md5 *ctx, const struct iovec *iov, int iovcnt);
 void ampheck_md5_finish(const struct ampheck_md5 *ctx, uint8_t *digest);
+void ampheck_md5_finish_inplace(struct ampheck_md5 *ctx, uint8_t *digest);
+void ampheck_md5_digest(const uint8_t *data, size_t length, uint8_t *digest);
+
+/* Batch versions over arrays of contexts; see sha256.h. */
+void ampheck_md5_init_batch(struct ampheck_md5 *ctx, size_t count);
+void ampheck_md5_update_batch(struct ampheck_md5 *ctx, const uint8_t *const data[], const size_t length[], size_t count);
+void ampheck_md5_finish_batch(const struct ampheck_md5 *ctx, uint8_t *const digest[], size_t count);
+void ampheck_md5_mgr_init(struct ampheck_mgr *mgr);
 
 #endif
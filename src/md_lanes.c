@@ -0,0 +1,294 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "backends.h"
+#include "lanes.h"
+#include "md4.h"
+#include "md5.h"
+
+#ifdef AMPHECK_X86
+
+/*
+	Eight (AVX2) or sixteen (AVX-512) MD4 or MD5 messages side by side, one
+	per 32-bit lane.  Both are little-endian, so the transposed rows are the
+	message words as they are.
+*/
+
+#define MD5_LANES_PRC(a, b, c, d, idx, rot, key, rnd) { \
+	wv[a] = ADD(wv[b], ROL(ADD(ADD(wv[a], MD5_R##rnd(wv[b], wv[c], wv[d])), ADD(w[idx], SET1(key))), rot)); \
+}
+
+#define MD4_LANES_PRC(a, b, c, d, idx, rot, rnd) { \
+	wv[a] = ROL(ADD(ADD(wv[a], MD4_R##rnd(wv[b], wv[c], wv[d])), w[idx]), rot); \
+}
+
+#define MD5_LANES_BLOCK() { \
+	wv[0] = s[0]; \
+	wv[1] = s[1]; \
+	wv[2] = s[2]; \
+	wv[3] = s[3]; \
+	\
+	MD5_LANES_PRC(0, 1, 2, 3,  0,  7, 0xd76aa478, 1); \
+	MD5_LANES_PRC(3, 0, 1, 2,  1, 12, 0xe8c7b756, 1); \
+	MD5_LANES_PRC(2, 3, 0, 1,  2, 17, 0x242070db, 1); \
+	MD5_LANES_PRC(1, 2, 3, 0,  3, 22, 0xc1bdceee, 1); \
+	MD5_LANES_PRC(0, 1, 2, 3,  4,  7, 0xf57c0faf, 1); \
+	MD5_LANES_PRC(3, 0, 1, 2,  5, 12, 0x4787c62a, 1); \
+	MD5_LANES_PRC(2, 3, 0, 1,  6, 17, 0xa8304613, 1); \
+	MD5_LANES_PRC(1, 2, 3, 0,  7, 22, 0xfd469501, 1); \
+	MD5_LANES_PRC(0, 1, 2, 3,  8,  7, 0x698098d8, 1); \
+	MD5_LANES_PRC(3, 0, 1, 2,  9, 12, 0x8b44f7af, 1); \
+	MD5_LANES_PRC(2, 3, 0, 1, 10, 17, 0xffff5bb1, 1); \
+	MD5_LANES_PRC(1, 2, 3, 0, 11, 22, 0x895cd7be, 1); \
+	MD5_LANES_PRC(0, 1, 2, 3, 12,  7, 0x6b901122, 1); \
+	MD5_LANES_PRC(3, 0, 1, 2, 13, 12, 0xfd987193, 1); \
+	MD5_LANES_PRC(2, 3, 0, 1, 14, 17, 0xa679438e, 1); \
+	MD5_LANES_PRC(1, 2, 3, 0, 15, 22, 0x49b40821, 1); \
+	\
+	MD5_LANES_PRC(0, 1, 2, 3,  1,  5, 0xf61e2562, 2); \
+	MD5_LANES_PRC(3, 0, 1, 2,  6,  9, 0xc040b340, 2); \
+	MD5_LANES_PRC(2, 3, 0, 1, 11, 14, 0x265e5a51, 2); \
+	MD5_LANES_PRC(1, 2, 3, 0,  0, 20, 0xe9b6c7aa, 2); \
+	MD5_LANES_PRC(0, 1, 2, 3,  5,  5, 0xd62f105d, 2); \
+	MD5_LANES_PRC(3, 0, 1, 2, 10,  9, 0x02441453, 2); \
+	MD5_LANES_PRC(2, 3, 0, 1, 15, 14, 0xd8a1e681, 2); \
+	MD5_LANES_PRC(1, 2, 3, 0,  4, 20, 0xe7d3fbc8, 2); \
+	MD5_LANES_PRC(0, 1, 2, 3,  9,  5, 0x21e1cde6, 2); \
+	MD5_LANES_PRC(3, 0, 1, 2, 14,  9, 0xc33707d6, 2); \
+	MD5_LANES_PRC(2, 3, 0, 1,  3, 14, 0xf4d50d87, 2); \
+	MD5_LANES_PRC(1, 2, 3, 0,  8, 20, 0x455a14ed, 2); \
+	MD5_LANES_PRC(0, 1, 2, 3, 13,  5, 0xa9e3e905, 2); \
+	MD5_LANES_PRC(3, 0, 1, 2,  2,  9, 0xfcefa3f8, 2); \
+	MD5_LANES_PRC(2, 3, 0, 1,  7, 14, 0x676f02d9, 2); \
+	MD5_LANES_PRC(1, 2, 3, 0, 12, 20, 0x8d2a4c8a, 2); \
+	\
+	MD5_LANES_PRC(0, 1, 2, 3,  5,  4, 0xfffa3942, 3); \
+	MD5_LANES_PRC(3, 0, 1, 2,  8, 11, 0x8771f681, 3); \
+	MD5_LANES_PRC(2, 3, 0, 1, 11, 16, 0x6d9d6122, 3); \
+	MD5_LANES_PRC(1, 2, 3, 0, 14, 23, 0xfde5380c, 3); \
+	MD5_LANES_PRC(0, 1, 2, 3,  1,  4, 0xa4beea44, 3); \
+	MD5_LANES_PRC(3, 0, 1, 2,  4, 11, 0x4bdecfa9, 3); \
+	MD5_LANES_PRC(2, 3, 0, 1,  7, 16, 0xf6bb4b60, 3); \
+	MD5_LANES_PRC(1, 2, 3, 0, 10, 23, 0xbebfbc70, 3); \
+	MD5_LANES_PRC(0, 1, 2, 3, 13,  4, 0x289b7ec6, 3); \
+	MD5_LANES_PRC(3, 0, 1, 2,  0, 11, 0xeaa127fa, 3); \
+	MD5_LANES_PRC(2, 3, 0, 1,  3, 16, 0xd4ef3085, 3); \
+	MD5_LANES_PRC(1, 2, 3, 0,  6, 23, 0x04881d05, 3); \
+	MD5_LANES_PRC(0, 1, 2, 3,  9,  4, 0xd9d4d039, 3); \
+	MD5_LANES_PRC(3, 0, 1, 2, 12, 11, 0xe6db99e5, 3); \
+	MD5_LANES_PRC(2, 3, 0, 1, 15, 16, 0x1fa27cf8, 3); \
+	MD5_LANES_PRC(1, 2, 3, 0,  2, 23, 0xc4ac5665, 3); \
+	\
+	MD5_LANES_PRC(0, 1, 2, 3,  0,  6, 0xf4292244, 4); \
+	MD5_LANES_PRC(3, 0, 1, 2,  7, 10, 0x432aff97, 4); \
+	MD5_LANES_PRC(2, 3, 0, 1, 14, 15, 0xab9423a7, 4); \
+	MD5_LANES_PRC(1, 2, 3, 0,  5, 21, 0xfc93a039, 4); \
+	MD5_LANES_PRC(0, 1, 2, 3, 12,  6, 0x655b59c3, 4); \
+	MD5_LANES_PRC(3, 0, 1, 2,  3, 10, 0x8f0ccc92, 4); \
+	MD5_LANES_PRC(2, 3, 0, 1, 10, 15, 0xffeff47d, 4); \
+	MD5_LANES_PRC(1, 2, 3, 0,  1, 21, 0x85845dd1, 4); \
+	MD5_LANES_PRC(0, 1, 2, 3,  8,  6, 0x6fa87e4f, 4); \
+	MD5_LANES_PRC(3, 0, 1, 2, 15, 10, 0xfe2ce6e0, 4); \
+	MD5_LANES_PRC(2, 3, 0, 1,  6, 15, 0xa3014314, 4); \
+	MD5_LANES_PRC(1, 2, 3, 0, 13, 21, 0x4e0811a1, 4); \
+	MD5_LANES_PRC(0, 1, 2, 3,  4,  6, 0xf7537e82, 4); \
+	MD5_LANES_PRC(3, 0, 1, 2, 11, 10, 0xbd3af235, 4); \
+	MD5_LANES_PRC(2, 3, 0, 1,  2, 15, 0x2ad7d2bb, 4); \
+	MD5_LANES_PRC(1, 2, 3, 0,  9, 21, 0xeb86d391, 4); \
+	\
+	s[0] = ADD(s[0], wv[0]); \
+	s[1] = ADD(s[1], wv[1]); \
+	s[2] = ADD(s[2], wv[2]); \
+	s[3] = ADD(s[3], wv[3]); \
+}
+
+#define MD4_LANES_BLOCK() { \
+	wv[0] = s[0]; \
+	wv[1] = s[1]; \
+	wv[2] = s[2]; \
+	wv[3] = s[3]; \
+	\
+	MD4_LANES_PRC(0, 1, 2, 3,  0,  3, 1); \
+	MD4_LANES_PRC(3, 0, 1, 2,  1,  7, 1); \
+	MD4_LANES_PRC(2, 3, 0, 1,  2, 11, 1); \
+	MD4_LANES_PRC(1, 2, 3, 0,  3, 19, 1); \
+	MD4_LANES_PRC(0, 1, 2, 3,  4,  3, 1); \
+	MD4_LANES_PRC(3, 0, 1, 2,  5,  7, 1); \
+	MD4_LANES_PRC(2, 3, 0, 1,  6, 11, 1); \
+	MD4_LANES_PRC(1, 2, 3, 0,  7, 19, 1); \
+	MD4_LANES_PRC(0, 1, 2, 3,  8,  3, 1); \
+	MD4_LANES_PRC(3, 0, 1, 2,  9,  7, 1); \
+	MD4_LANES_PRC(2, 3, 0, 1, 10, 11, 1); \
+	MD4_LANES_PRC(1, 2, 3, 0, 11, 19, 1); \
+	MD4_LANES_PRC(0, 1, 2, 3, 12,  3, 1); \
+	MD4_LANES_PRC(3, 0, 1, 2, 13,  7, 1); \
+	MD4_LANES_PRC(2, 3, 0, 1, 14, 11, 1); \
+	MD4_LANES_PRC(1, 2, 3, 0, 15, 19, 1); \
+	\
+	MD4_LANES_PRC(0, 1, 2, 3,  0,  3, 2); \
+	MD4_LANES_PRC(3, 0, 1, 2,  4,  5, 2); \
+	MD4_LANES_PRC(2, 3, 0, 1,  8,  9, 2); \
+	MD4_LANES_PRC(1, 2, 3, 0, 12, 13, 2); \
+	MD4_LANES_PRC(0, 1, 2, 3,  1,  3, 2); \
+	MD4_LANES_PRC(3, 0, 1, 2,  5,  5, 2); \
+	MD4_LANES_PRC(2, 3, 0, 1,  9,  9, 2); \
+	MD4_LANES_PRC(1, 2, 3, 0, 13, 13, 2); \
+	MD4_LANES_PRC(0, 1, 2, 3,  2,  3, 2); \
+	MD4_LANES_PRC(3, 0, 1, 2,  6,  5, 2); \
+	MD4_LANES_PRC(2, 3, 0, 1, 10,  9, 2); \
+	MD4_LANES_PRC(1, 2, 3, 0, 14, 13, 2); \
+	MD4_LANES_PRC(0, 1, 2, 3,  3,  3, 2); \
+	MD4_LANES_PRC(3, 0, 1, 2,  7,  5, 2); \
+	MD4_LANES_PRC(2, 3, 0, 1, 11,  9, 2); \
+	MD4_LANES_PRC(1, 2, 3, 0, 15, 13, 2); \
+	\
+	MD4_LANES_PRC(0, 1, 2, 3,  0,  3, 3); \
+	MD4_LANES_PRC(3, 0, 1, 2,  8,  9, 3); \
+	MD4_LANES_PRC(2, 3, 0, 1,  4, 11, 3); \
+	MD4_LANES_PRC(1, 2, 3, 0, 12, 15, 3); \
+	MD4_LANES_PRC(0, 1, 2, 3,  2,  3, 3); \
+	MD4_LANES_PRC(3, 0, 1, 2, 10,  9, 3); \
+	MD4_LANES_PRC(2, 3, 0, 1,  6, 11, 3); \
+	MD4_LANES_PRC(1, 2, 3, 0, 14, 15, 3); \
+	MD4_LANES_PRC(0, 1, 2, 3,  1,  3, 3); \
+	MD4_LANES_PRC(3, 0, 1, 2,  9,  9, 3); \
+	MD4_LANES_PRC(2, 3, 0, 1,  5, 11, 3); \
+	MD4_LANES_PRC(1, 2, 3, 0, 13, 15, 3); \
+	MD4_LANES_PRC(0, 1, 2, 3,  3,  3, 3); \
+	MD4_LANES_PRC(3, 0, 1, 2, 11,  9, 3); \
+	MD4_LANES_PRC(2, 3, 0, 1,  7, 11, 3); \
+	MD4_LANES_PRC(1, 2, 3, 0, 15, 15, 3); \
+	\
+	s[0] = ADD(s[0], wv[0]); \
+	s[1] = ADD(s[1], wv[1]); \
+	s[2] = ADD(s[2], wv[2]); \
+	s[3] = ADD(s[3], wv[3]); \
+}
+
+#define MD_LANES_AVX2(algo, ALGO) \
+__attribute__((target("avx2"))) \
+void ampheck_##algo##_lanes_avx2(void *state, const uint8_t *const data[], size_t blocks) \
+{ \
+	__m256i *h = state; \
+	__m256i s[4]; \
+	\
+	for (int j = 0; j < 4; ++j) \
+	{ \
+		s[j] = _mm256_loadu_si256(&h[j]); \
+	} \
+	\
+	for (size_t i = 0; i < blocks; ++i) \
+	{ \
+		__m256i wv[4]; \
+		__m256i w[16]; \
+		\
+		for (int j = 0; j < 8; ++j) \
+		{ \
+			w[j    ] = _mm256_loadu_si256((const __m256i *) &data[j][(i << 6)     ]); \
+			w[j + 8] = _mm256_loadu_si256((const __m256i *) &data[j][(i << 6) + 32]); \
+		} \
+		\
+		ampheck_transpose8(&w[0]); \
+		ampheck_transpose8(&w[8]); \
+		\
+		ALGO##_LANES_BLOCK(); \
+	} \
+	\
+	for (int j = 0; j < 4; ++j) \
+	{ \
+		_mm256_storeu_si256(&h[j], s[j]); \
+	} \
+}
+
+#define MD_LANES_AVX512(algo, ALGO) \
+__attribute__((target("avx512f"))) \
+void ampheck_##algo##_lanes_avx512(void *state, const uint8_t *const data[], size_t blocks) \
+{ \
+	__m512i *h = state; \
+	__m512i s[4]; \
+	\
+	for (int j = 0; j < 4; ++j) \
+	{ \
+		s[j] = _mm512_loadu_si512(&h[j]); \
+	} \
+	\
+	for (size_t i = 0; i < blocks; ++i) \
+	{ \
+		__m512i wv[4]; \
+		__m512i w[16]; \
+		\
+		for (int j = 0; j < 16; ++j) \
+		{ \
+			w[j] = _mm512_loadu_si512(&data[j][i << 6]); \
+		} \
+		\
+		ampheck_transpose16(w); \
+		\
+		ALGO##_LANES_BLOCK(); \
+	} \
+	\
+	for (int j = 0; j < 4; ++j) \
+	{ \
+		_mm512_storeu_si512(&h[j], s[j]); \
+	} \
+}
+
+#define ADD(x, y) _mm256_add_epi32(x, y)
+#define SET1(x) _mm256_set1_epi32((int) (x))
+#define ROL(x, y) _mm256_or_si256(_mm256_slli_epi32(x, y), _mm256_srli_epi32(x, 32 - (y)))
+#define NOT(x) _mm256_xor_si256(x, _mm256_set1_epi32(-1))
+#define CH(x, y, z) _mm256_xor_si256(z, _mm256_and_si256(x, _mm256_xor_si256(y, z)))
+#define MAJ(x, y, z) _mm256_or_si256(_mm256_and_si256(x, y), _mm256_and_si256(z, _mm256_or_si256(x, y)))
+#define XOR3(x, y, z) _mm256_xor_si256(_mm256_xor_si256(x, y), z)
+
+#define MD5_R1(x, y, z) CH(x, y, z)
+#define MD5_R2(x, y, z) CH(z, x, y)
+#define MD5_R3(x, y, z) XOR3(x, y, z)
+#define MD5_R4(x, y, z) _mm256_xor_si256(y, _mm256_or_si256(x, NOT(z)))
+
+#define MD4_R1(x, y, z) CH(x, y, z)
+#define MD4_R2(x, y, z) ADD(MAJ(x, y, z), SET1(0x5a827999))
+#define MD4_R3(x, y, z) ADD(XOR3(x, y, z), SET1(0x6ed9eba1))
+
+MD_LANES_AVX2(md4, MD4)
+MD_LANES_AVX2(md5, MD5)
+
+#undef ADD
+#undef SET1
+#undef ROL
+#undef NOT
+#undef CH
+#undef MAJ
+#undef XOR3
+#undef MD5_R4
+
+#define ADD(x, y) _mm512_add_epi32(x, y)
+#define SET1(x) _mm512_set1_epi32((int) (x))
+#define ROL(x, y) _mm512_rol_epi32(x, y)
+#define CH(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0xCA)
+#define MAJ(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0xE8)
+#define XOR3(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0x96)
+
+#define MD5_R4(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0x39)
+
+MD_LANES_AVX512(md4, MD4)
+MD_LANES_AVX512(md5, MD5)
+
+#endif
@@ -0,0 +1,89 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ampheck_mgr_h
+#define ampheck_mgr_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define AMPHECK_JOB_FIRST 0x01
+#define AMPHECK_JOB_LAST  0x02
+
+#define AMPHECK_MGR_LANES 16
+
+/*
+	A job continues the message in `ctx', a context of the manager's
+	algorithm, with `length' bytes of `data'.  AMPHECK_JOB_FIRST initialises
+	the context first; AMPHECK_JOB_LAST writes the digest to `digest' once
+	the data is in, after which the context must be initialised again.  The
+	job, its context and its data belong to the manager from submit until the
+	job is handed back.  `user' is left alone.
+*/
+struct ampheck_job
+{
+	void *ctx;
+	const uint8_t *data;
+	size_t length;
+	unsigned int flags;
+	uint8_t *digest;
+	void *user;
+	
+	/* Private to the manager. */
+	const uint8_t *head;
+	const uint8_t *next;
+	size_t blocks;
+	const uint8_t *tail;
+	size_t rest;
+	size_t fill;
+	int final;
+};
+
+struct ampheck_batch;
+struct ampheck_lanes;
+
+/*
+	Keeps up to AMPHECK_MGR_LANES jobs in the SIMD lanes of one kernel and
+	advances them all by the blocks the shortest one has left.  Set it up
+	with ampheck_<algo>_mgr_init().
+
+	ampheck_mgr_submit() takes a job and hands back a finished one, possibly
+	the same, or NULL while lanes are still free.  ampheck_mgr_flush() hands
+	back the remaining jobs one per call, then NULL.  The order of the jobs
+	handed back is unspecified.
+*/
+struct ampheck_mgr
+{
+	struct ampheck_batch *batch;
+	const struct ampheck_lanes *kernel;
+	unsigned int lanes;
+	unsigned int active;
+	unsigned int finished;
+	
+	struct ampheck_job *lane[AMPHECK_MGR_LANES];
+	struct ampheck_job *done[AMPHECK_MGR_LANES];
+	const uint8_t *data[AMPHECK_MGR_LANES];
+	size_t remaining[AMPHECK_MGR_LANES];
+	
+	uint64_t state[8 * AMPHECK_MGR_LANES];
+	uint8_t final[AMPHECK_MGR_LANES][256];
+};
+
+struct ampheck_job *ampheck_mgr_submit(struct ampheck_mgr *mgr, struct ampheck_job *job);
+struct ampheck_job *ampheck_mgr_flush(struct ampheck_mgr *mgr);
+
+#endif
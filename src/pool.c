@@ -0,0 +1,455 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "md4.h"
+#include "md5.h"
+#include "pool.h"
+#include "ripemd128.h"
+#include "ripemd160.h"
+#include "sha0.h"
+#include "sha1.h"
+#include "sha224.h"
+#include "sha256.h"
+#include "sha384.h"
+#include "sha512.h"
+#include "sha512_224.h"
+#include "sha512_256.h"
+
+/*
+	Every worker owns a queue of jobs, a context and a read buffer.  It runs
+	the oldest job from the front of its own queue and, when that is empty,
+	steals the newest one from the back of the others'.  The pool counts the
+	jobs still queued, so that idle workers know when to sleep, and the jobs
+	not yet done, for ampheck_pool_wait().  The pool lock is always taken
+	before a queue lock, never the other way round.
+*/
+
+#define BUFFER (64 * 1024)
+
+union context
+{
+	struct ampheck_md4 md4;
+	struct ampheck_md5 md5;
+	struct ampheck_ripemd128 ripemd128;
+	struct ampheck_ripemd160 ripemd160;
+	struct ampheck_sha0 sha0;
+	struct ampheck_sha1 sha1;
+	struct ampheck_sha224 sha224;
+	struct ampheck_sha256 sha256;
+	struct ampheck_sha384 sha384;
+	struct ampheck_sha512 sha512;
+	struct ampheck_sha512_224 sha512_224;
+	struct ampheck_sha512_256 sha512_256;
+};
+
+struct hash
+{
+	const char *name;
+	void (*init)(union context *ctx);
+	void (*update)(union context *ctx, const uint8_t *data, size_t length);
+	void (*finish)(union context *ctx, uint8_t *digest);
+};
+
+#define HASH(algo) \
+static void init_##algo(union context *ctx) \
+{ \
+	ampheck_##algo##_init(&ctx->algo); \
+} \
+\
+static void update_##algo(union context *ctx, const uint8_t *data, size_t length) \
+{ \
+	ampheck_##algo##_update(&ctx->algo, data, length); \
+} \
+\
+static void finish_##algo(union context *ctx, uint8_t *digest) \
+{ \
+	ampheck_##algo##_finish_inplace(&ctx->algo, digest); \
+}
+
+HASH(md4)
+HASH(md5)
+HASH(ripemd128)
+HASH(ripemd160)
+HASH(sha0)
+HASH(sha1)
+HASH(sha224)
+HASH(sha256)
+HASH(sha384)
+HASH(sha512)
+HASH(sha512_224)
+HASH(sha512_256)
+
+static const struct hash hashes[] =
+{
+	{ "md4",       init_md4,       update_md4,       finish_md4 },
+	{ "md5",       init_md5,       update_md5,       finish_md5 },
+	{ "ripemd128", init_ripemd128, update_ripemd128, finish_ripemd128 },
+	{ "ripemd160", init_ripemd160, update_ripemd160, finish_ripemd160 },
+	{ "sha0",      init_sha0,      update_sha0,      finish_sha0 },
+	{ "sha1",      init_sha1,      update_sha1,      finish_sha1 },
+	{ "sha224",    init_sha224,    update_sha224,    finish_sha224 },
+	{ "sha256",    init_sha256,    update_sha256,    finish_sha256 },
+	{ "sha384",    init_sha384,    update_sha384,    finish_sha384 },
+	{ "sha512",    init_sha512,    update_sha512,    finish_sha512 },
+	{ "sha512_224", init_sha512_224, update_sha512_224, finish_sha512_224 },
+	{ "sha512_256", init_sha512_256, update_sha512_256, finish_sha512_256 }
+};
+
+struct worker
+{
+	struct ampheck_pool *pool;
+	pthread_t thread;
+	pthread_mutex_t lock;
+	struct ampheck_pool_job *head;
+	struct ampheck_pool_job *tail;
+	uint8_t *buffer;
+};
+
+struct ampheck_pool
+{
+	pthread_mutex_t lock;
+	pthread_cond_t work;
+	pthread_cond_t idle;
+	size_t queued;
+	size_t pending;
+	unsigned int next;
+	unsigned int threads;
+	unsigned int started;
+	int stopping;
+	struct worker *workers;
+};
+
+/* Takes the job at the front or, for thieves, the back of the queue of `worker'. */
+static struct ampheck_pool_job *take(struct worker *worker, int back)
+{
+	struct ampheck_pool_job *job;
+	
+	pthread_mutex_lock(&worker->lock);
+	
+	job = back ? worker->tail : worker->head;
+	
+	if (job != NULL)
+	{
+		if (job->prev != NULL)
+		{
+			job->prev->next = job->next;
+		}
+		else
+		{
+			worker->head = job->next;
+		}
+		
+		if (job->next != NULL)
+		{
+			job->next->prev = job->prev;
+		}
+		else
+		{
+			worker->tail = job->prev;
+		}
+	}
+	
+	pthread_mutex_unlock(&worker->lock);
+	
+	return job;
+}
+
+static struct ampheck_pool_job *find(struct worker *worker)
+{
+	struct ampheck_pool *pool = worker->pool;
+	const unsigned int self = (unsigned int) (worker - pool->workers);
+	struct ampheck_pool_job *job = take(worker, 0);
+	
+	for (unsigned int i = 1; job == NULL && i < pool->threads; ++i)
+	{
+		job = take(&pool->workers[(self + i) % pool->threads], 1);
+	}
+	
+	if (job != NULL)
+	{
+		pthread_mutex_lock(&pool->lock);
+		--pool->queued;
+		pthread_mutex_unlock(&pool->lock);
+	}
+	
+	return job;
+}
+
+static void run(struct worker *worker, struct ampheck_pool_job *job)
+{
+	struct ampheck_pool *pool = worker->pool;
+	const struct hash *hash = job->hash;
+	const int event = job->event;
+	union context ctx;
+	
+	hash->init(&ctx);
+	job->error = 0;
+	
+	if (job->fd < 0)
+	{
+		hash->update(&ctx, job->data, job->length);
+	}
+	else
+	{
+		for (;;)
+		{
+			ssize_t size = read(job->fd, worker->buffer, BUFFER);
+			
+			if (size > 0)
+			{
+				hash->update(&ctx, worker->buffer, (size_t) size);
+			}
+			else if (size == 0)
+			{
+				break;
+			}
+			else if (errno != EINTR)
+			{
+				job->error = errno;
+				break;
+			}
+		}
+	}
+	
+	if (job->error == 0)
+	{
+		hash->finish(&ctx, job->digest);
+	}
+	
+	if (job->done != NULL)
+	{
+		job->done(job);
+	}
+	
+	if (event >= 0)
+	{
+		const uint64_t one = 1;
+		
+		while (write(event, &one, sizeof(one)) < 0 && errno == EINTR)
+		{
+		}
+	}
+	
+	pthread_mutex_lock(&pool->lock);
+	
+	if (--pool->pending == 0)
+	{
+		pthread_cond_broadcast(&pool->idle);
+	}
+	
+	pthread_mutex_unlock(&pool->lock);
+}
+
+static void *work(void *arg)
+{
+	struct worker *worker = arg;
+	struct ampheck_pool *pool = worker->pool;
+	
+	for (;;)
+	{
+		struct ampheck_pool_job *job = find(worker);
+		int stop;
+		
+		if (job != NULL)
+		{
+			run(worker, job);
+			continue;
+		}
+		
+		pthread_mutex_lock(&pool->lock);
+		
+		while (pool->queued == 0 && !pool->stopping)
+		{
+			pthread_cond_wait(&pool->work, &pool->lock);
+		}
+		
+		stop = pool->queued == 0;
+		
+		pthread_mutex_unlock(&pool->lock);
+		
+		if (stop)
+		{
+			return NULL;
+		}
+	}
+}
+
+struct ampheck_pool *ampheck_pool_new(unsigned int threads)
+{
+	struct ampheck_pool *pool;
+	
+	if (threads == 0)
+	{
+		long online = sysconf(_SC_NPROCESSORS_ONLN);
+		
+		threads = online > 0 ? (unsigned int) online : 1;
+	}
+	
+	pool = malloc(sizeof(*pool));
+	
+	if (pool == NULL)
+	{
+		return NULL;
+	}
+	
+	pool->workers = calloc(threads, sizeof(*pool->workers));
+	
+	if (pool->workers == NULL)
+	{
+		free(pool);
+		
+		return NULL;
+	}
+	
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->work, NULL);
+	pthread_cond_init(&pool->idle, NULL);
+	
+	pool->queued = 0;
+	pool->pending = 0;
+	pool->next = 0;
+	pool->threads = threads;
+	pool->started = 0;
+	pool->stopping = 0;
+	
+	for (unsigned int i = 0; i < threads; ++i)
+	{
+		struct worker *worker = &pool->workers[i];
+		
+		worker->pool = pool;
+		worker->head = NULL;
+		worker->tail = NULL;
+		worker->buffer = malloc(BUFFER);
+		
+		pthread_mutex_init(&worker->lock, NULL);
+	}
+	
+	for (unsigned int i = 0; i < threads; ++i)
+	{
+		if (pool->workers[i].buffer == NULL || pthread_create(&pool->workers[i].thread, NULL, work, &pool->workers[i]) != 0)
+		{
+			ampheck_pool_free(pool);
+			
+			return NULL;
+		}
+		
+		++pool->started;
+	}
+	
+	return pool;
+}
+
+int ampheck_pool_submit(struct ampheck_pool *pool, struct ampheck_pool_job *job)
+{
+	struct worker *worker;
+	
+	job->hash = NULL;
+	
+	for (size_t i = 0; i < sizeof(hashes) / sizeof(*hashes); ++i)
+	{
+		if (strcmp(job->algorithm, hashes[i].name) == 0)
+		{
+			job->hash = &hashes[i];
+		}
+	}
+	
+	if (job->hash == NULL)
+	{
+		return -1;
+	}
+	
+	pthread_mutex_lock(&pool->lock);
+	
+	worker = &pool->workers[pool->next++ % pool->threads];
+	
+	pthread_mutex_lock(&worker->lock);
+	
+	job->next = NULL;
+	job->prev = worker->tail;
+	
+	if (worker->tail != NULL)
+	{
+		worker->tail->next = job;
+	}
+	else
+	{
+		worker->head = job;
+	}
+	
+	worker->tail = job;
+	
+	pthread_mutex_unlock(&worker->lock);
+	
+	++pool->queued;
+	++pool->pending;
+	
+	pthread_cond_signal(&pool->work);
+	pthread_mutex_unlock(&pool->lock);
+	
+	return 0;
+}
+
+void ampheck_pool_wait(struct ampheck_pool *pool)
+{
+	pthread_mutex_lock(&pool->lock);
+	
+	while (pool->pending > 0)
+	{
+		pthread_cond_wait(&pool->idle, &pool->lock);
+	}
+	
+	pthread_mutex_unlock(&pool->lock);
+}
+
+void ampheck_pool_free(struct ampheck_pool *pool)
+{
+	ampheck_pool_wait(pool);
+	
+	pthread_mutex_lock(&pool->lock);
+	pool->stopping = 1;
+	pthread_cond_broadcast(&pool->work);
+	pthread_mutex_unlock(&pool->lock);
+	
+	for (unsigned int i = 0; i < pool->started; ++i)
+	{
+		pthread_join(pool->workers[i].thread, NULL);
+	}
+	
+	for (unsigned int i = 0; i < pool->threads; ++i)
+	{
+		pthread_mutex_destroy(&pool->workers[i].lock);
+		free(pool->workers[i].buffer);
+	}
+	
+	pthread_cond_destroy(&pool->idle);
+	pthread_cond_destroy(&pool->work);
+	pthread_mutex_destroy(&pool->lock);
+	
+	free(pool->workers);
+	free(pool);
+}
@@ -0,0 +1,74 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ampheck_pool_h
+#define ampheck_pool_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+	A job hashes `length' bytes of `data' or, when `fd' is not negative,
+	everything that can still be read from `fd', with the algorithm named by
+	`algorithm' ("md4" to "sha512_256"), into `digest'.  If reading fails, `error'
+	is set to the errno value and the digest is undefined; otherwise it is 0.
+
+	When the job is done, `done' is called from the worker that ran it, if it
+	is set, and then 1 is added to the eventfd `event' unless it is negative.
+	The job is the caller's again from the call to `done' on, so `event' is
+	read before it.  `user' is left alone.
+*/
+struct ampheck_pool_job
+{
+	const char *algorithm;
+	const uint8_t *data;
+	size_t length;
+	int fd;
+	
+	uint8_t *digest;
+	int error;
+	
+	void (*done)(struct ampheck_pool_job *job);
+	int event;
+	void *user;
+	
+	/* Private to the pool. */
+	const void *hash;
+	struct ampheck_pool_job *next;
+	struct ampheck_pool_job *prev;
+};
+
+struct ampheck_pool;
+
+/*
+	Starts `threads' workers, or one per online CPU when it is 0.  Jobs are
+	spread over the workers' queues as they are submitted, and a worker whose
+	queue runs dry takes the newest job from the back of another's, so a few
+	long jobs do not hold up the ones queued behind them.  Each worker keeps
+	its own context and read buffer; submitting a job allocates nothing.
+
+	ampheck_pool_new() returns NULL if the pool cannot be set up, and
+	ampheck_pool_submit() returns -1 for an unknown algorithm, 0 otherwise.
+	ampheck_pool_wait() returns once every job submitted so far is done.
+	ampheck_pool_free() waits for the jobs too, then stops the workers.
+*/
+struct ampheck_pool *ampheck_pool_new(unsigned int threads);
+int ampheck_pool_submit(struct ampheck_pool *pool, struct ampheck_pool_job *job);
+void ampheck_pool_wait(struct ampheck_pool *pool);
+void ampheck_pool_free(struct ampheck_pool *pool);
+
+#endif
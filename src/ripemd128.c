@@ -19,7 +19,10 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <sys/uio.h>
+
 #include "ampheck.h"
+#include "backends.h"
 #include "ripemd128.h"
 
 #define RIPEMD128_R1(x, y, z)  (x ^ y ^ z)
@@ -43,9 +46,10 @@ void ampheck_ripemd128_init(struct ampheck_ripemd128 *ctx)
 	ctx->h[3] = 0x10325476;
 	
 	ctx->length = 0;
+	ctx->fill = 0;
 }
 
-void ampheck_ripemd128_transform(struct ampheck_ripemd128 *ctx, const uint8_t *data, size_t blocks)
+void ampheck_ripemd128_transform_generic(struct ampheck_ripemd128 *ctx, const uint8_t *data, size_t blocks)
 {
 	for (size_t i = 0; i < blocks; ++i)
 	{
@@ -219,59 +223,124 @@ void ampheck_ripemd128_transform(struct ampheck_ripemd128 *ctx, const uint8_t *d
 	}
 }
 
-void ampheck_ripemd128_update(struct ampheck_ripemd128 *ctx, const uint8_t *data, size_t size)
+const struct ampheck_backend ampheck_ripemd128_backends[] =
+{
+	{ "generic", 0, (ampheck_backend_fn) ampheck_ripemd128_transform_generic },
+	{ NULL, 0, NULL }
+};
+
+void ampheck_ripemd128_transform(struct ampheck_ripemd128 *ctx, const uint8_t *data, size_t blocks)
 {
-	size_t tmp = size;
+	static void (*transform)(struct ampheck_ripemd128 *, const uint8_t *, size_t) = NULL;
+	void (*selected)(struct ampheck_ripemd128 *, const uint8_t *, size_t) = AMPHECK_LOAD(transform);
 	
-	if (size >= 64 - ctx->length % 64)
+	if (selected == NULL)
+	{
+		selected = (void (*)(struct ampheck_ripemd128 *, const uint8_t *, size_t)) ampheck_backend_select("ripemd128", ampheck_ripemd128_backends)->transform;
+		AMPHECK_STORE(transform, selected);
+	}
+	
+	selected(ctx, data, blocks);
+}
+
+static void __attribute__((noinline)) ripemd128_update_blocks(struct ampheck_ripemd128 *ctx, const uint8_t *data, size_t size)
+{
+	if (ctx->fill > 0)
 	{
-		memcpy(&ctx->buffer[ctx->length % 64], data, 64 - ctx->length % 64);
+		memcpy(&ctx->buffer[ctx->fill], data, 64 - ctx->fill);
 		
-		data += 64 - ctx->length % 64;
-		size -= 64 - ctx->length % 64;
+		data += 64 - ctx->fill;
+		size -= 64 - ctx->fill;
 		
 		ampheck_ripemd128_transform(ctx, ctx->buffer, 1);
-		ampheck_ripemd128_transform(ctx, data, size / 64);
-		
-		data += size & ~63;
-		size %= 64;
+	}
+	
+	ampheck_ripemd128_transform(ctx, data, size / 64);
+	
+	data += size & ~(size_t) 63;
+	ctx->fill = (uint32_t) (size % 64);
+	
+	memcpy(ctx->buffer, data, ctx->fill);
+}
+
+void ampheck_ripemd128_update(struct ampheck_ripemd128 *ctx, const uint8_t *data, size_t size)
+{
+	ctx->length += size;
+	
+	if (size < 64 - ctx->fill)
+	{
+		uint8_t *p = &ctx->buffer[ctx->fill];
 		
-		memcpy(ctx->buffer, data, size);
+		ctx->fill += (uint32_t) size;
+		memcpy(p, data, size);
 	}
 	else
 	{
-		memcpy(&ctx->buffer[ctx->length % 64], data, size);
+		ripemd128_update_blocks(ctx, data, size);
+	}
+}
+
+void ampheck_ripemd128_updatev(struct ampheck_ripemd128 *ctx, const struct iovec *iov, int iovcnt)
+{
+	for (int i = 0; i < iovcnt; ++i)
+	{
+		ampheck_ripemd128_update(ctx, iov[i].iov_base, iov[i].iov_len);
 	}
-	
-	ctx->length += tmp;
 }
 
 void ampheck_ripemd128_finish(const struct ampheck_ripemd128 *ctx, uint8_t *digest)
 {
 	struct ampheck_ripemd128 tmp;
 	
-	memcpy(tmp.h, ctx->h, 4 * sizeof(uint32_t));
-	memcpy(tmp.buffer, ctx->buffer, ctx->length % 64);
+	memcpy(tmp.h, ctx->h, sizeof(tmp.h));
+	memcpy(tmp.buffer, ctx->buffer, ctx->fill);
+	tmp.length = ctx->length;
+	tmp.fill = ctx->fill;
 	
-	tmp.buffer[ctx->length % 64] = 0x80;
+	ampheck_ripemd128_finish_inplace(&tmp, digest);
+}
+
+void ampheck_ripemd128_finish_inplace(struct ampheck_ripemd128 *ctx, uint8_t *digest)
+{
+	ctx->buffer[ctx->fill] = 0x80;
 	
-	if (ctx->length % 64 < 56)
+	if (ctx->fill < 56)
 	{
-		memset(&tmp.buffer[ctx->length % 64 + 1], 0x00, 55 - ctx->length % 64);
+		memset(&ctx->buffer[ctx->fill + 1], 0x00, 55 - ctx->fill);
 	}
 	else
 	{
-		memset(&tmp.buffer[ctx->length % 64 + 1], 0x00, 63 - ctx->length % 64);
-		ampheck_ripemd128_transform(&tmp, tmp.buffer, 1);
+		memset(&ctx->buffer[ctx->fill + 1], 0x00, 63 - ctx->fill);
+		ampheck_ripemd128_transform(ctx, ctx->buffer, 1);
 		
-		memset(tmp.buffer, 0x00, 56);
+		memset(ctx->buffer, 0x00, 56);
 	}
 	
-	UNPACK_64_LE(ctx->length * 8, &tmp.buffer[56]);
-	ampheck_ripemd128_transform(&tmp, tmp.buffer, 1);
+	UNPACK_64_LE(ctx->length * 8, &ctx->buffer[56]);
+	ampheck_ripemd128_transform(ctx, ctx->buffer, 1);
 	
-	UNPACK_32_LE(tmp.h[0], &digest[ 0]);
-	UNPACK_32_LE(tmp.h[1], &digest[ 4]);
-	UNPACK_32_LE(tmp.h[2], &digest[ 8]);
-	UNPACK_32_LE(tmp.h[3], &digest[12]);
+	UNPACK_32_LE(ctx->h[0], &digest[ 0]);
+	UNPACK_32_LE(ctx->h[1], &digest[ 4]);
+	UNPACK_32_LE(ctx->h[2], &digest[ 8]);
+	UNPACK_32_LE(ctx->h[3], &digest[12]);
+}
+
+void ampheck_ripemd128_digest(const uint8_t *data, size_t length, uint8_t *digest)
+{
+	struct ampheck_ripemd128 ctx;
+	uint8_t final[128];
+	
+	ampheck_ripemd128_init(&ctx);
+	
+	if (length >= 64)
+	{
+		ampheck_ripemd128_transform(&ctx, data, length / 64);
+	}
+	
+	ampheck_ripemd128_transform(&ctx, final, ampheck_final(final, &data[length & ~(size_t) 63], length, 64, 0));
+	
+	for (int j = 0; j < 4; ++j)
+	{
+		UNPACK_32_LE(ctx.h[j], &digest[j * 4]);
+	}
 }
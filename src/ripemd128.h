@@ -21,16 +21,24 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "align.h"
+
+struct iovec;
+
 struct ampheck_ripemd128
 {
 	uint32_t h[4];
-	uint8_t buffer[64];
-	
 	uint64_t length;
+	uint32_t fill;
+	
+	AMPHECK_ALIGNED(64) uint8_t buffer[64];
 };
 
 void ampheck_ripemd128_init(struct ampheck_ripemd128 *ctx);
 void ampheck_ripemd128_update(struct ampheck_ripemd128 *ctx, const uint8_t *data, size_t length);
+void ampheck_ripemd128_updatev(struct ampheck_ripemd128 *ctx, const struct iovec *iov, int iovcnt);
 void ampheck_ripemd128_finish(const struct ampheck_ripemd128 *ctx, uint8_t *digest);
+void ampheck_ripemd128_finish_inplace(struct ampheck_ripemd128 *ctx, uint8_t *digest);
+void ampheck_ripemd128_digest(const uint8_t *data, size_t length, uint8_t *digest);
 
 #endif
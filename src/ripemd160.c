@@ -19,7 +19,10 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <sys/uio.h>
+
 #include "ampheck.h"
+#include "backends.h"
 #include "ripemd160.h"
 
 #define RIPEMD160_R1(x, y, z)  (x ^ y ^ z)
@@ -47,9 +50,10 @@ void ampheck_ripemd160_init(struct ampheck_ripemd160 *ctx)
 	ctx->h[4] = 0xc3d2e1f0;
 	
 	ctx->length = 0;
+	ctx->fill = 0;
 }
 
-void ampheck_ripemd160_transform(struct ampheck_ripemd160 *ctx, const uint8_t *data, size_t blocks)
+void ampheck_ripemd160_transform_generic(struct ampheck_ripemd160 *ctx, const uint8_t *data, size_t blocks)
 {
 	for (size_t i = 0; i < blocks; ++i)
 	{
@@ -259,60 +263,183 @@ void ampheck_ripemd160_transform(struct ampheck_ripemd160 *ctx, const uint8_t *d
 	}
 }
 
-void ampheck_ripemd160_update(struct ampheck_ripemd160 *ctx, const uint8_t *data, size_t size)
+const struct ampheck_backend ampheck_ripemd160_backends[] =
 {
-	size_t tmp = size;
+#ifdef AMPHECK_X86
+	{ "avx2", AMPHECK_CPU_AVX2, (ampheck_backend_fn) ampheck_ripemd160_transform_avx2 },
+#endif
+	{ "generic", 0, (ampheck_backend_fn) ampheck_ripemd160_transform_generic },
+	{ NULL, 0, NULL }
+};
+
+void ampheck_ripemd160_transform(struct ampheck_ripemd160 *ctx, const uint8_t *data, size_t blocks)
+{
+	static void (*transform)(struct ampheck_ripemd160 *, const uint8_t *, size_t) = NULL;
+	void (*selected)(struct ampheck_ripemd160 *, const uint8_t *, size_t) = AMPHECK_LOAD(transform);
 	
-	if (size >= 64 - ctx->length % 64)
+	if (selected == NULL)
 	{
-		memcpy(&ctx->buffer[ctx->length % 64], data, 64 - ctx->length % 64);
+		selected = (void (*)(struct ampheck_ripemd160 *, const uint8_t *, size_t)) ampheck_backend_select("ripemd160", ampheck_ripemd160_backends)->transform;
+		AMPHECK_STORE(transform, selected);
+	}
+	
+	selected(ctx, data, blocks);
+}
+
+const struct ampheck_lanes ampheck_ripemd160_lanes[] =
+{
+#ifdef AMPHECK_X86
+	{ "avx512", AMPHECK_CPU_AVX512F, 16, ampheck_ripemd160_lanes_avx512 },
+	{ "avx2", AMPHECK_CPU_AVX2, 8, ampheck_ripemd160_lanes_avx2 },
+#endif
+	{ "generic", 0, 1, NULL },
+	{ NULL, 0, 0, NULL }
+};
+
+static void ripemd160_batch_transform(void *h, const uint8_t *data, size_t blocks)
+{
+	struct ampheck_ripemd160 ctx;
+	
+	memcpy(ctx.h, h, sizeof(ctx.h));
+	ampheck_ripemd160_transform(&ctx, data, blocks);
+	memcpy(h, ctx.h, sizeof(ctx.h));
+}
+
+static void ripemd160_batch_init(void *ctx)
+{
+	ampheck_ripemd160_init(ctx);
+}
+
+static struct ampheck_batch ripemd160_batch =
+{
+	"ripemd160", ampheck_ripemd160_lanes, NULL, ripemd160_batch_transform, ripemd160_batch_init,
+	sizeof(struct ampheck_ripemd160), offsetof(struct ampheck_ripemd160, buffer),
+	offsetof(struct ampheck_ripemd160, length), offsetof(struct ampheck_ripemd160, fill),
+	5, 4, 64, 20, 0
+};
+
+static void __attribute__((noinline)) ripemd160_update_blocks(struct ampheck_ripemd160 *ctx, const uint8_t *data, size_t size)
+{
+	if (ctx->fill > 0)
+	{
+		memcpy(&ctx->buffer[ctx->fill], data, 64 - ctx->fill);
 		
-		data += 64 - ctx->length % 64;
-		size -= 64 - ctx->length % 64;
+		data += 64 - ctx->fill;
+		size -= 64 - ctx->fill;
 		
 		ampheck_ripemd160_transform(ctx, ctx->buffer, 1);
-		ampheck_ripemd160_transform(ctx, data, size / 64);
-		
-		data += size & ~63;
-		size %= 64;
+	}
+	
+	ampheck_ripemd160_transform(ctx, data, size / 64);
+	
+	data += size & ~(size_t) 63;
+	ctx->fill = (uint32_t) (size % 64);
+	
+	memcpy(ctx->buffer, data, ctx->fill);
+}
+
+void ampheck_ripemd160_update(struct ampheck_ripemd160 *ctx, const uint8_t *data, size_t size)
+{
+	ctx->length += size;
+	
+	if (size < 64 - ctx->fill)
+	{
+		uint8_t *p = &ctx->buffer[ctx->fill];
 		
-		memcpy(ctx->buffer, data, size);
+		ctx->fill += (uint32_t) size;
+		memcpy(p, data, size);
 	}
 	else
 	{
-		memcpy(&ctx->buffer[ctx->length % 64], data, size);
+		ripemd160_update_blocks(ctx, data, size);
+	}
+}
+
+void ampheck_ripemd160_updatev(struct ampheck_ripemd160 *ctx, const struct iovec *iov, int iovcnt)
+{
+	for (int i = 0; i < iovcnt; ++i)
+	{
+		ampheck_ripemd160_update(ctx, iov[i].iov_base, iov[i].iov_len);
 	}
-	
-	ctx->length += tmp;
 }
 
 void ampheck_ripemd160_finish(const struct ampheck_ripemd160 *ctx, uint8_t *digest)
 {
 	struct ampheck_ripemd160 tmp;
 	
-	memcpy(tmp.h, ctx->h, 5 * sizeof(uint32_t));
-	memcpy(tmp.buffer, ctx->buffer, ctx->length % 64);
+	memcpy(tmp.h, ctx->h, sizeof(tmp.h));
+	memcpy(tmp.buffer, ctx->buffer, ctx->fill);
+	tmp.length = ctx->length;
+	tmp.fill = ctx->fill;
 	
-	tmp.buffer[ctx->length % 64] = 0x80;
+	ampheck_ripemd160_finish_inplace(&tmp, digest);
+}
+
+void ampheck_ripemd160_finish_inplace(struct ampheck_ripemd160 *ctx, uint8_t *digest)
+{
+	ctx->buffer[ctx->fill] = 0x80;
 	
-	if (ctx->length % 64 < 56)
+	if (ctx->fill < 56)
 	{
-		memset(&tmp.buffer[ctx->length % 64 + 1], 0x00, 55 - ctx->length % 64);
+		memset(&ctx->buffer[ctx->fill + 1], 0x00, 55 - ctx->fill);
 	}
 	else
 	{
-		memset(&tmp.buffer[ctx->length % 64 + 1], 0x00, 63 - ctx->length % 64);
-		ampheck_ripemd160_transform(&tmp, tmp.buffer, 1);
+		memset(&ctx->buffer[ctx->fill + 1], 0x00, 63 - ctx->fill);
+		ampheck_ripemd160_transform(ctx, ctx->buffer, 1);
 		
-		memset(tmp.buffer, 0x00, 56);
+		memset(ctx->buffer, 0x00, 56);
+	}
+	
+	UNPACK_64_LE(ctx->length * 8, &ctx->buffer[56]);
+	ampheck_ripemd160_transform(ctx, ctx->buffer, 1);
+	
+	UNPACK_32_LE(ctx->h[0], &digest[ 0]);
+	UNPACK_32_LE(ctx->h[1], &digest[ 4]);
+	UNPACK_32_LE(ctx->h[2], &digest[ 8]);
+	UNPACK_32_LE(ctx->h[3], &digest[12]);
+	UNPACK_32_LE(ctx->h[4], &digest[16]);
+}
+
+void ampheck_ripemd160_digest(const uint8_t *data, size_t length, uint8_t *digest)
+{
+	struct ampheck_ripemd160 ctx;
+	uint8_t final[128];
+	
+	ampheck_ripemd160_init(&ctx);
+	
+	if (length >= 64)
+	{
+		ampheck_ripemd160_transform(&ctx, data, length / 64);
 	}
 	
-	UNPACK_64_LE(ctx->length * 8, &tmp.buffer[56]);
-	ampheck_ripemd160_transform(&tmp, tmp.buffer, 1);
+	ampheck_ripemd160_transform(&ctx, final, ampheck_final(final, &data[length & ~(size_t) 63], length, 64, 0));
 	
-	UNPACK_32_LE(tmp.h[0], &digest[ 0]);
-	UNPACK_32_LE(tmp.h[1], &digest[ 4]);
-	UNPACK_32_LE(tmp.h[2], &digest[ 8]);
-	UNPACK_32_LE(tmp.h[3], &digest[12]);
-	UNPACK_32_LE(tmp.h[4], &digest[16]);
+	for (int j = 0; j < 5; ++j)
+	{
+		UNPACK_32_LE(ctx.h[j], &digest[j * 4]);
+	}
+}
+
+void ampheck_ripemd160_init_batch(struct ampheck_ripemd160 *ctx, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		ampheck_ripemd160_init(&ctx[i]);
+	}
+}
+
+void ampheck_ripemd160_update_batch(struct ampheck_ripemd160 *ctx, const uint8_t *const data[], const size_t length[], size_t count)
+{
+	ampheck_batch_update(&ripemd160_batch, ctx, data, length, count);
+}
+
+void ampheck_ripemd160_finish_batch(const struct ampheck_ripemd160 *ctx, uint8_t *const digest[], size_t count)
+{
+	ampheck_batch_finish(&ripemd160_batch, ctx, digest, count);
+}
+
+void ampheck_ripemd160_mgr_init(struct ampheck_mgr *mgr)
+{
+	ampheck_mgr_init(mgr, &ripemd160_batch);
 }
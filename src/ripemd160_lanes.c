@@ -0,0 +1,328 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "backends.h"
+#include "lanes.h"
+#include "ripemd160.h"
+
+#ifdef AMPHECK_X86
+
+/*
+	Eight (AVX2) or sixteen (AVX-512) RIPEMD-160 messages side by side, one
+	per 32-bit lane; both lines of each message run in the same vectors.
+	The round list is the one of ripemd160.c.
+*/
+
+#define RIPEMD160_LANES_PRC(a, b, c, d, e, idx, rot, rnd) { \
+	wv[a] = ADD(ROL(ADD(ADD(wv[a], RIPEMD160_R##rnd(wv[b], wv[c], wv[d])), w[idx]), rot), wv[e]); \
+	wv[c] = ROL(wv[c], 10); \
+}
+
+#define RIPEMD160_LANES_BLOCK() { \
+	for (int j = 0; j < 5; ++j) \
+	{ \
+		wv[j] = wv[j + 5] = s[j]; \
+	} \
+	\
+	RIPEMD160_LANES_PRC(0, 1, 2, 3, 4,  0, 11,  1); \
+	RIPEMD160_LANES_PRC(4, 0, 1, 2, 3,  1, 14,  1); \
+	RIPEMD160_LANES_PRC(3, 4, 0, 1, 2,  2, 15,  1); \
+	RIPEMD160_LANES_PRC(2, 3, 4, 0, 1,  3, 12,  1); \
+	RIPEMD160_LANES_PRC(1, 2, 3, 4, 0,  4,  5,  1); \
+	RIPEMD160_LANES_PRC(0, 1, 2, 3, 4,  5,  8,  1); \
+	RIPEMD160_LANES_PRC(4, 0, 1, 2, 3,  6,  7,  1); \
+	RIPEMD160_LANES_PRC(3, 4, 0, 1, 2,  7,  9,  1); \
+	RIPEMD160_LANES_PRC(2, 3, 4, 0, 1,  8, 11,  1); \
+	RIPEMD160_LANES_PRC(1, 2, 3, 4, 0,  9, 13,  1); \
+	RIPEMD160_LANES_PRC(0, 1, 2, 3, 4, 10, 14,  1); \
+	RIPEMD160_LANES_PRC(4, 0, 1, 2, 3, 11, 15,  1); \
+	RIPEMD160_LANES_PRC(3, 4, 0, 1, 2, 12,  6,  1); \
+	RIPEMD160_LANES_PRC(2, 3, 4, 0, 1, 13,  7,  1); \
+	RIPEMD160_LANES_PRC(1, 2, 3, 4, 0, 14,  9,  1); \
+	RIPEMD160_LANES_PRC(0, 1, 2, 3, 4, 15,  8,  1); \
+	\
+	RIPEMD160_LANES_PRC(4, 0, 1, 2, 3,  7,  7,  2); \
+	RIPEMD160_LANES_PRC(3, 4, 0, 1, 2,  4,  6,  2); \
+	RIPEMD160_LANES_PRC(2, 3, 4, 0, 1, 13,  8,  2); \
+	RIPEMD160_LANES_PRC(1, 2, 3, 4, 0,  1, 13,  2); \
+	RIPEMD160_LANES_PRC(0, 1, 2, 3, 4, 10, 11,  2); \
+	RIPEMD160_LANES_PRC(4, 0, 1, 2, 3,  6,  9,  2); \
+	RIPEMD160_LANES_PRC(3, 4, 0, 1, 2, 15,  7,  2); \
+	RIPEMD160_LANES_PRC(2, 3, 4, 0, 1,  3, 15,  2); \
+	RIPEMD160_LANES_PRC(1, 2, 3, 4, 0, 12,  7,  2); \
+	RIPEMD160_LANES_PRC(0, 1, 2, 3, 4,  0, 12,  2); \
+	RIPEMD160_LANES_PRC(4, 0, 1, 2, 3,  9, 15,  2); \
+	RIPEMD160_LANES_PRC(3, 4, 0, 1, 2,  5,  9,  2); \
+	RIPEMD160_LANES_PRC(2, 3, 4, 0, 1,  2, 11,  2); \
+	RIPEMD160_LANES_PRC(1, 2, 3, 4, 0, 14,  7,  2); \
+	RIPEMD160_LANES_PRC(0, 1, 2, 3, 4, 11, 13,  2); \
+	RIPEMD160_LANES_PRC(4, 0, 1, 2, 3,  8, 12,  2); \
+	\
+	RIPEMD160_LANES_PRC(3, 4, 0, 1, 2,  3, 11,  3); \
+	RIPEMD160_LANES_PRC(2, 3, 4, 0, 1, 10, 13,  3); \
+	RIPEMD160_LANES_PRC(1, 2, 3, 4, 0, 14,  6,  3); \
+	RIPEMD160_LANES_PRC(0, 1, 2, 3, 4,  4,  7,  3); \
+	RIPEMD160_LANES_PRC(4, 0, 1, 2, 3,  9, 14,  3); \
+	RIPEMD160_LANES_PRC(3, 4, 0, 1, 2, 15,  9,  3); \
+	RIPEMD160_LANES_PRC(2, 3, 4, 0, 1,  8, 13,  3); \
+	RIPEMD160_LANES_PRC(1, 2, 3, 4, 0,  1, 15,  3); \
+	RIPEMD160_LANES_PRC(0, 1, 2, 3, 4,  2, 14,  3); \
+	RIPEMD160_LANES_PRC(4, 0, 1, 2, 3,  7,  8,  3); \
+	RIPEMD160_LANES_PRC(3, 4, 0, 1, 2,  0, 13,  3); \
+	RIPEMD160_LANES_PRC(2, 3, 4, 0, 1,  6,  6,  3); \
+	RIPEMD160_LANES_PRC(1, 2, 3, 4, 0, 13,  5,  3); \
+	RIPEMD160_LANES_PRC(0, 1, 2, 3, 4, 11, 12,  3); \
+	RIPEMD160_LANES_PRC(4, 0, 1, 2, 3,  5,  7,  3); \
+	RIPEMD160_LANES_PRC(3, 4, 0, 1, 2, 12,  5,  3); \
+	\
+	RIPEMD160_LANES_PRC(2, 3, 4, 0, 1,  1, 11,  4); \
+	RIPEMD160_LANES_PRC(1, 2, 3, 4, 0,  9, 12,  4); \
+	RIPEMD160_LANES_PRC(0, 1, 2, 3, 4, 11, 14,  4); \
+	RIPEMD160_LANES_PRC(4, 0, 1, 2, 3, 10, 15,  4); \
+	RIPEMD160_LANES_PRC(3, 4, 0, 1, 2,  0, 14,  4); \
+	RIPEMD160_LANES_PRC(2, 3, 4, 0, 1,  8, 15,  4); \
+	RIPEMD160_LANES_PRC(1, 2, 3, 4, 0, 12,  9,  4); \
+	RIPEMD160_LANES_PRC(0, 1, 2, 3, 4,  4,  8,  4); \
+	RIPEMD160_LANES_PRC(4, 0, 1, 2, 3, 13,  9,  4); \
+	RIPEMD160_LANES_PRC(3, 4, 0, 1, 2,  3, 14,  4); \
+	RIPEMD160_LANES_PRC(2, 3, 4, 0, 1,  7,  5,  4); \
+	RIPEMD160_LANES_PRC(1, 2, 3, 4, 0, 15,  6,  4); \
+	RIPEMD160_LANES_PRC(0, 1, 2, 3, 4, 14,  8,  4); \
+	RIPEMD160_LANES_PRC(4, 0, 1, 2, 3,  5,  6,  4); \
+	RIPEMD160_LANES_PRC(3, 4, 0, 1, 2,  6,  5,  4); \
+	RIPEMD160_LANES_PRC(2, 3, 4, 0, 1,  2, 12,  4); \
+	\
+	RIPEMD160_LANES_PRC(1, 2, 3, 4, 0,  4,  9,  5); \
+	RIPEMD160_LANES_PRC(0, 1, 2, 3, 4,  0, 15,  5); \
+	RIPEMD160_LANES_PRC(4, 0, 1, 2, 3,  5,  5,  5); \
+	RIPEMD160_LANES_PRC(3, 4, 0, 1, 2,  9, 11,  5); \
+	RIPEMD160_LANES_PRC(2, 3, 4, 0, 1,  7,  6,  5); \
+	RIPEMD160_LANES_PRC(1, 2, 3, 4, 0, 12,  8,  5); \
+	RIPEMD160_LANES_PRC(0, 1, 2, 3, 4,  2, 13,  5); \
+	RIPEMD160_LANES_PRC(4, 0, 1, 2, 3, 10, 12,  5); \
+	RIPEMD160_LANES_PRC(3, 4, 0, 1, 2, 14,  5,  5); \
+	RIPEMD160_LANES_PRC(2, 3, 4, 0, 1,  1, 12,  5); \
+	RIPEMD160_LANES_PRC(1, 2, 3, 4, 0,  3, 13,  5); \
+	RIPEMD160_LANES_PRC(0, 1, 2, 3, 4,  8, 14,  5); \
+	RIPEMD160_LANES_PRC(4, 0, 1, 2, 3, 11, 11,  5); \
+	RIPEMD160_LANES_PRC(3, 4, 0, 1, 2,  6,  8,  5); \
+	RIPEMD160_LANES_PRC(2, 3, 4, 0, 1, 15,  5,  5); \
+	RIPEMD160_LANES_PRC(1, 2, 3, 4, 0, 13,  6,  5); \
+	\
+	RIPEMD160_LANES_PRC(5, 6, 7, 8, 9,  5,  8,  6); \
+	RIPEMD160_LANES_PRC(9, 5, 6, 7, 8, 14,  9,  6); \
+	RIPEMD160_LANES_PRC(8, 9, 5, 6, 7,  7,  9,  6); \
+	RIPEMD160_LANES_PRC(7, 8, 9, 5, 6,  0, 11,  6); \
+	RIPEMD160_LANES_PRC(6, 7, 8, 9, 5,  9, 13,  6); \
+	RIPEMD160_LANES_PRC(5, 6, 7, 8, 9,  2, 15,  6); \
+	RIPEMD160_LANES_PRC(9, 5, 6, 7, 8, 11, 15,  6); \
+	RIPEMD160_LANES_PRC(8, 9, 5, 6, 7,  4,  5,  6); \
+	RIPEMD160_LANES_PRC(7, 8, 9, 5, 6, 13,  7,  6); \
+	RIPEMD160_LANES_PRC(6, 7, 8, 9, 5,  6,  7,  6); \
+	RIPEMD160_LANES_PRC(5, 6, 7, 8, 9, 15,  8,  6); \
+	RIPEMD160_LANES_PRC(9, 5, 6, 7, 8,  8, 11,  6); \
+	RIPEMD160_LANES_PRC(8, 9, 5, 6, 7,  1, 14,  6); \
+	RIPEMD160_LANES_PRC(7, 8, 9, 5, 6, 10, 14,  6); \
+	RIPEMD160_LANES_PRC(6, 7, 8, 9, 5,  3, 12,  6); \
+	RIPEMD160_LANES_PRC(5, 6, 7, 8, 9, 12,  6,  6); \
+	\
+	RIPEMD160_LANES_PRC(9, 5, 6, 7, 8,  6,  9,  7); \
+	RIPEMD160_LANES_PRC(8, 9, 5, 6, 7, 11, 13,  7); \
+	RIPEMD160_LANES_PRC(7, 8, 9, 5, 6,  3, 15,  7); \
+	RIPEMD160_LANES_PRC(6, 7, 8, 9, 5,  7,  7,  7); \
+	RIPEMD160_LANES_PRC(5, 6, 7, 8, 9,  0, 12,  7); \
+	RIPEMD160_LANES_PRC(9, 5, 6, 7, 8, 13,  8,  7); \
+	RIPEMD160_LANES_PRC(8, 9, 5, 6, 7,  5,  9,  7); \
+	RIPEMD160_LANES_PRC(7, 8, 9, 5, 6, 10, 11,  7); \
+	RIPEMD160_LANES_PRC(6, 7, 8, 9, 5, 14,  7,  7); \
+	RIPEMD160_LANES_PRC(5, 6, 7, 8, 9, 15,  7,  7); \
+	RIPEMD160_LANES_PRC(9, 5, 6, 7, 8,  8, 12,  7); \
+	RIPEMD160_LANES_PRC(8, 9, 5, 6, 7, 12,  7,  7); \
+	RIPEMD160_LANES_PRC(7, 8, 9, 5, 6,  4,  6,  7); \
+	RIPEMD160_LANES_PRC(6, 7, 8, 9, 5,  9, 15,  7); \
+	RIPEMD160_LANES_PRC(5, 6, 7, 8, 9,  1, 13,  7); \
+	RIPEMD160_LANES_PRC(9, 5, 6, 7, 8,  2, 11,  7); \
+	\
+	RIPEMD160_LANES_PRC(8, 9, 5, 6, 7, 15,  9,  8); \
+	RIPEMD160_LANES_PRC(7, 8, 9, 5, 6,  5,  7,  8); \
+	RIPEMD160_LANES_PRC(6, 7, 8, 9, 5,  1, 15,  8); \
+	RIPEMD160_LANES_PRC(5, 6, 7, 8, 9,  3, 11,  8); \
+	RIPEMD160_LANES_PRC(9, 5, 6, 7, 8,  7,  8,  8); \
+	RIPEMD160_LANES_PRC(8, 9, 5, 6, 7, 14,  6,  8); \
+	RIPEMD160_LANES_PRC(7, 8, 9, 5, 6,  6,  6,  8); \
+	RIPEMD160_LANES_PRC(6, 7, 8, 9, 5,  9, 14,  8); \
+	RIPEMD160_LANES_PRC(5, 6, 7, 8, 9, 11, 12,  8); \
+	RIPEMD160_LANES_PRC(9, 5, 6, 7, 8,  8, 13,  8); \
+	RIPEMD160_LANES_PRC(8, 9, 5, 6, 7, 12,  5,  8); \
+	RIPEMD160_LANES_PRC(7, 8, 9, 5, 6,  2, 14,  8); \
+	RIPEMD160_LANES_PRC(6, 7, 8, 9, 5, 10, 13,  8); \
+	RIPEMD160_LANES_PRC(5, 6, 7, 8, 9,  0, 13,  8); \
+	RIPEMD160_LANES_PRC(9, 5, 6, 7, 8,  4,  7,  8); \
+	RIPEMD160_LANES_PRC(8, 9, 5, 6, 7, 13,  5,  8); \
+	\
+	RIPEMD160_LANES_PRC(7, 8, 9, 5, 6,  8, 15,  9); \
+	RIPEMD160_LANES_PRC(6, 7, 8, 9, 5,  6,  5,  9); \
+	RIPEMD160_LANES_PRC(5, 6, 7, 8, 9,  4,  8,  9); \
+	RIPEMD160_LANES_PRC(9, 5, 6, 7, 8,  1, 11,  9); \
+	RIPEMD160_LANES_PRC(8, 9, 5, 6, 7,  3, 14,  9); \
+	RIPEMD160_LANES_PRC(7, 8, 9, 5, 6, 11, 14,  9); \
+	RIPEMD160_LANES_PRC(6, 7, 8, 9, 5, 15,  6,  9); \
+	RIPEMD160_LANES_PRC(5, 6, 7, 8, 9,  0, 14,  9); \
+	RIPEMD160_LANES_PRC(9, 5, 6, 7, 8,  5,  6,  9); \
+	RIPEMD160_LANES_PRC(8, 9, 5, 6, 7, 12,  9,  9); \
+	RIPEMD160_LANES_PRC(7, 8, 9, 5, 6,  2, 12,  9); \
+	RIPEMD160_LANES_PRC(6, 7, 8, 9, 5, 13,  9,  9); \
+	RIPEMD160_LANES_PRC(5, 6, 7, 8, 9,  9, 12,  9); \
+	RIPEMD160_LANES_PRC(9, 5, 6, 7, 8,  7,  5,  9); \
+	RIPEMD160_LANES_PRC(8, 9, 5, 6, 7, 10, 15,  9); \
+	RIPEMD160_LANES_PRC(7, 8, 9, 5, 6, 14,  8,  9); \
+	\
+	RIPEMD160_LANES_PRC(6, 7, 8, 9, 5, 12,  8, 10); \
+	RIPEMD160_LANES_PRC(5, 6, 7, 8, 9, 15,  5, 10); \
+	RIPEMD160_LANES_PRC(9, 5, 6, 7, 8, 10, 12, 10); \
+	RIPEMD160_LANES_PRC(8, 9, 5, 6, 7,  4,  9, 10); \
+	RIPEMD160_LANES_PRC(7, 8, 9, 5, 6,  1, 12, 10); \
+	RIPEMD160_LANES_PRC(6, 7, 8, 9, 5,  5,  5, 10); \
+	RIPEMD160_LANES_PRC(5, 6, 7, 8, 9,  8, 14, 10); \
+	RIPEMD160_LANES_PRC(9, 5, 6, 7, 8,  7,  6, 10); \
+	RIPEMD160_LANES_PRC(8, 9, 5, 6, 7,  6,  8, 10); \
+	RIPEMD160_LANES_PRC(7, 8, 9, 5, 6,  2, 13, 10); \
+	RIPEMD160_LANES_PRC(6, 7, 8, 9, 5, 13,  6, 10); \
+	RIPEMD160_LANES_PRC(5, 6, 7, 8, 9, 14,  5, 10); \
+	RIPEMD160_LANES_PRC(9, 5, 6, 7, 8,  0, 15, 10); \
+	RIPEMD160_LANES_PRC(8, 9, 5, 6, 7,  3, 13, 10); \
+	RIPEMD160_LANES_PRC(7, 8, 9, 5, 6,  9, 11, 10); \
+	RIPEMD160_LANES_PRC(6, 7, 8, 9, 5, 11, 11, 10); \
+	\
+	wv[8] = ADD(wv[8], ADD(wv[2], s[1])); \
+	s[1] = ADD(s[2], ADD(wv[3], wv[9])); \
+	s[2] = ADD(s[3], ADD(wv[4], wv[5])); \
+	s[3] = ADD(s[4], ADD(wv[0], wv[6])); \
+	s[4] = ADD(s[0], ADD(wv[1], wv[7])); \
+	s[0] = wv[8]; \
+}
+
+#define RIPEMD160_R2(x, y, z)  ADD(F2(x, y, z), SET1(0x5a827999))
+#define RIPEMD160_R3(x, y, z)  ADD(F3(x, y, z), SET1(0x6ed9eba1))
+#define RIPEMD160_R4(x, y, z)  ADD(F4(x, y, z), SET1(0x8f1bbcdc))
+#define RIPEMD160_R5(x, y, z)  ADD(F5(x, y, z), SET1(0xa953fd4e))
+#define RIPEMD160_R6(x, y, z)  ADD(F5(x, y, z), SET1(0x50a28be6))
+#define RIPEMD160_R7(x, y, z)  ADD(F4(x, y, z), SET1(0x5c4dd124))
+#define RIPEMD160_R8(x, y, z)  ADD(F3(x, y, z), SET1(0x6d703ef3))
+#define RIPEMD160_R9(x, y, z)  ADD(F2(x, y, z), SET1(0x7a6d76e9))
+#define RIPEMD160_R1(x, y, z)  F1(x, y, z)
+#define RIPEMD160_R10(x, y, z) F1(x, y, z)
+
+#define ADD(x, y) _mm256_add_epi32(x, y)
+#define SET1(x) _mm256_set1_epi32((int) (x))
+#define ROL(x, y) _mm256_or_si256(_mm256_slli_epi32(x, y), _mm256_srli_epi32(x, 32 - (y)))
+#define NOT(x) _mm256_xor_si256(x, _mm256_set1_epi32(-1))
+#define F1(x, y, z) _mm256_xor_si256(_mm256_xor_si256(x, y), z)
+#define F2(x, y, z) _mm256_xor_si256(z, _mm256_and_si256(x, _mm256_xor_si256(y, z)))
+#define F3(x, y, z) _mm256_xor_si256(_mm256_or_si256(x, NOT(y)), z)
+#define F4(x, y, z) F2(z, x, y)
+#define F5(x, y, z) _mm256_xor_si256(x, _mm256_or_si256(y, NOT(z)))
+
+__attribute__((target("avx2")))
+void ampheck_ripemd160_lanes_avx2(void *state, const uint8_t *const data[], size_t blocks)
+{
+	__m256i *h = state;
+	__m256i s[5];
+	
+	for (int j = 0; j < 5; ++j)
+	{
+		s[j] = _mm256_loadu_si256(&h[j]);
+	}
+	
+	for (size_t i = 0; i < blocks; ++i)
+	{
+		__m256i wv[10];
+		__m256i w[16];
+		
+		for (int j = 0; j < 8; ++j)
+		{
+			w[j    ] = _mm256_loadu_si256((const __m256i *) &data[j][(i << 6)     ]);
+			w[j + 8] = _mm256_loadu_si256((const __m256i *) &data[j][(i << 6) + 32]);
+		}
+		
+		ampheck_transpose8(&w[0]);
+		ampheck_transpose8(&w[8]);
+		
+		RIPEMD160_LANES_BLOCK();
+	}
+	
+	for (int j = 0; j < 5; ++j)
+	{
+		_mm256_storeu_si256(&h[j], s[j]);
+	}
+}
+
+#undef ADD
+#undef SET1
+#undef ROL
+#undef NOT
+#undef F1
+#undef F2
+#undef F3
+#undef F4
+#undef F5
+
+#define ADD(x, y) _mm512_add_epi32(x, y)
+#define SET1(x) _mm512_set1_epi32((int) (x))
+#define ROL(x, y) _mm512_rol_epi32(x, y)
+#define F1(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0x96)
+#define F2(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0xCA)
+#define F3(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0x59)
+#define F4(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0xE4)
+#define F5(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0x2D)
+
+__attribute__((target("avx512f")))
+void ampheck_ripemd160_lanes_avx512(void *state, const uint8_t *const data[], size_t blocks)
+{
+	__m512i *h = state;
+	__m512i s[5];
+	
+	for (int j = 0; j < 5; ++j)
+	{
+		s[j] = _mm512_loadu_si512(&h[j]);
+	}
+	
+	for (size_t i = 0; i < blocks; ++i)
+	{
+		__m512i wv[10];
+		__m512i w[16];
+		
+		for (int j = 0; j < 16; ++j)
+		{
+			w[j] = _mm512_loadu_si512(&data[j][i << 6]);
+		}
+		
+		ampheck_transpose16(w);
+		
+		RIPEMD160_LANES_BLOCK();
+	}
+	
+	for (int j = 0; j < 5; ++j)
+	{
+		_mm512_storeu_si512(&h[j], s[j]);
+	}
+}
+
+#endif
@@ -0,0 +1,202 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ampheck.h"
+#include "backends.h"
+#include "ripemd160.h"
+
+#ifdef AMPHECK_X86
+
+#include <immintrin.h>
+
+/*
+	The left line runs in lane 0 and the right line in lane 1.  Each step
+	evaluates both boolean functions of its round, blends them, and rotates
+	each lane by its own amount with VPSLLVD/VPSRLVD.
+*/
+
+#define RIPEMD_F1(x, y, z) _mm_xor_si128(_mm_xor_si128(x, y), z)
+#define RIPEMD_F2(x, y, z) _mm_xor_si128(z, _mm_and_si128(x, _mm_xor_si128(y, z)))
+#define RIPEMD_F3(x, y, z) _mm_xor_si128(_mm_or_si128(x, _mm_xor_si128(y, ones)), z)
+#define RIPEMD_F4(x, y, z) _mm_xor_si128(y, _mm_and_si128(z, _mm_xor_si128(x, y)))
+#define RIPEMD_F5(x, y, z) _mm_xor_si128(x, _mm_or_si128(y, _mm_xor_si128(z, ones)))
+
+#define RIPEMD_PAIR(l, r, x, y, z) _mm_blend_epi32(RIPEMD_F##l(x, y, z), RIPEMD_F##r(x, y, z), 0x02)
+
+#define RIPEMD_ROL(x, y) _mm_or_si128(_mm_slli_epi32(x, y), _mm_srli_epi32(x, 32 - (y)))
+#define RIPEMD_ROLV(x, l, r) _mm_or_si128(_mm_sllv_epi32(x, _mm_set_epi32(0, 0, r, l)), \
+                                          _mm_srlv_epi32(x, _mm_set_epi32(0, 0, 32 - (r), 32 - (l))))
+
+#define RIPEMD160_VEC_R1(x, y, z) _mm_add_epi32(RIPEMD_PAIR(1, 5, x, y, z), _mm_set_epi32(0, 0, 0x50a28be6, 0x00000000))
+#define RIPEMD160_VEC_R2(x, y, z) _mm_add_epi32(RIPEMD_PAIR(2, 4, x, y, z), _mm_set_epi32(0, 0, 0x5c4dd124, 0x5a827999))
+#define RIPEMD160_VEC_R3(x, y, z) _mm_add_epi32(RIPEMD_F3(x, y, z),         _mm_set_epi32(0, 0, 0x6d703ef3, 0x6ed9eba1))
+#define RIPEMD160_VEC_R4(x, y, z) _mm_add_epi32(RIPEMD_PAIR(4, 2, x, y, z), _mm_set_epi32(0, 0, 0x7a6d76e9, 0x8f1bbcdc))
+#define RIPEMD160_VEC_R5(x, y, z) _mm_add_epi32(RIPEMD_PAIR(5, 1, x, y, z), _mm_set_epi32(0, 0, 0x00000000, 0xa953fd4e))
+
+#define RIPEMD160_VEC_PRC(a, b, c, d, e, l, r, sl, sr, rnd) { \
+	__m128i t = _mm_add_epi32(wv[a], _mm_set_epi32(0, 0, r, l)); \
+	t = _mm_add_epi32(t, RIPEMD160_VEC_R##rnd(wv[b], wv[c], wv[d])); \
+	wv[a] = _mm_add_epi32(RIPEMD_ROLV(t, sl, sr), wv[e]); \
+	wv[c] = RIPEMD_ROL(wv[c], 10); \
+}
+
+#define RIPEMD_VEC_UNPACK(lanes, x, y, z) { \
+	uint32_t pair[2]; \
+	\
+	_mm_storel_epi64((__m128i *) pair, lanes); \
+	x[y] = pair[0]; \
+	x[z] = pair[1]; \
+}
+
+__attribute__((target("avx2")))
+void ampheck_ripemd160_transform_avx2(struct ampheck_ripemd160 *ctx, const uint8_t *data, size_t blocks)
+{
+	const __m128i ones = _mm_set1_epi32(-1);
+	
+	for (size_t i = 0; i < blocks; ++i)
+	{
+		__m128i wv[5];
+		uint32_t lv[10];
+		uint32_t w[16];
+		
+		PACK_32_LE(&data[(i << 6)     ], &w[ 0]);
+		PACK_32_LE(&data[(i << 6) +  4], &w[ 1]);
+		PACK_32_LE(&data[(i << 6) +  8], &w[ 2]);
+		PACK_32_LE(&data[(i << 6) + 12], &w[ 3]);
+		PACK_32_LE(&data[(i << 6) + 16], &w[ 4]);
+		PACK_32_LE(&data[(i << 6) + 20], &w[ 5]);
+		PACK_32_LE(&data[(i << 6) + 24], &w[ 6]);
+		PACK_32_LE(&data[(i << 6) + 28], &w[ 7]);
+		PACK_32_LE(&data[(i << 6) + 32], &w[ 8]);
+		PACK_32_LE(&data[(i << 6) + 36], &w[ 9]);
+		PACK_32_LE(&data[(i << 6) + 40], &w[10]);
+		PACK_32_LE(&data[(i << 6) + 44], &w[11]);
+		PACK_32_LE(&data[(i << 6) + 48], &w[12]);
+		PACK_32_LE(&data[(i << 6) + 52], &w[13]);
+		PACK_32_LE(&data[(i << 6) + 56], &w[14]);
+		PACK_32_LE(&data[(i << 6) + 60], &w[15]);
+		
+		wv[0] = _mm_set1_epi32(ctx->h[0]);
+		wv[1] = _mm_set1_epi32(ctx->h[1]);
+		wv[2] = _mm_set1_epi32(ctx->h[2]);
+		wv[3] = _mm_set1_epi32(ctx->h[3]);
+		wv[4] = _mm_set1_epi32(ctx->h[4]);
+		
+		RIPEMD160_VEC_PRC(0, 1, 2, 3, 4, w[ 0], w[ 5], 11,  8, 1);
+		RIPEMD160_VEC_PRC(4, 0, 1, 2, 3, w[ 1], w[14], 14,  9, 1);
+		RIPEMD160_VEC_PRC(3, 4, 0, 1, 2, w[ 2], w[ 7], 15,  9, 1);
+		RIPEMD160_VEC_PRC(2, 3, 4, 0, 1, w[ 3], w[ 0], 12, 11, 1);
+		RIPEMD160_VEC_PRC(1, 2, 3, 4, 0, w[ 4], w[ 9],  5, 13, 1);
+		RIPEMD160_VEC_PRC(0, 1, 2, 3, 4, w[ 5], w[ 2],  8, 15, 1);
+		RIPEMD160_VEC_PRC(4, 0, 1, 2, 3, w[ 6], w[11],  7, 15, 1);
+		RIPEMD160_VEC_PRC(3, 4, 0, 1, 2, w[ 7], w[ 4],  9,  5, 1);
+		RIPEMD160_VEC_PRC(2, 3, 4, 0, 1, w[ 8], w[13], 11,  7, 1);
+		RIPEMD160_VEC_PRC(1, 2, 3, 4, 0, w[ 9], w[ 6], 13,  7, 1);
+		RIPEMD160_VEC_PRC(0, 1, 2, 3, 4, w[10], w[15], 14,  8, 1);
+		RIPEMD160_VEC_PRC(4, 0, 1, 2, 3, w[11], w[ 8], 15, 11, 1);
+		RIPEMD160_VEC_PRC(3, 4, 0, 1, 2, w[12], w[ 1],  6, 14, 1);
+		RIPEMD160_VEC_PRC(2, 3, 4, 0, 1, w[13], w[10],  7, 14, 1);
+		RIPEMD160_VEC_PRC(1, 2, 3, 4, 0, w[14], w[ 3],  9, 12, 1);
+		RIPEMD160_VEC_PRC(0, 1, 2, 3, 4, w[15], w[12],  8,  6, 1);
+		
+		RIPEMD160_VEC_PRC(4, 0, 1, 2, 3, w[ 7], w[ 6],  7,  9, 2);
+		RIPEMD160_VEC_PRC(3, 4, 0, 1, 2, w[ 4], w[11],  6, 13, 2);
+		RIPEMD160_VEC_PRC(2, 3, 4, 0, 1, w[13], w[ 3],  8, 15, 2);
+		RIPEMD160_VEC_PRC(1, 2, 3, 4, 0, w[ 1], w[ 7], 13,  7, 2);
+		RIPEMD160_VEC_PRC(0, 1, 2, 3, 4, w[10], w[ 0], 11, 12, 2);
+		RIPEMD160_VEC_PRC(4, 0, 1, 2, 3, w[ 6], w[13],  9,  8, 2);
+		RIPEMD160_VEC_PRC(3, 4, 0, 1, 2, w[15], w[ 5],  7,  9, 2);
+		RIPEMD160_VEC_PRC(2, 3, 4, 0, 1, w[ 3], w[10], 15, 11, 2);
+		RIPEMD160_VEC_PRC(1, 2, 3, 4, 0, w[12], w[14],  7,  7, 2);
+		RIPEMD160_VEC_PRC(0, 1, 2, 3, 4, w[ 0], w[15], 12,  7, 2);
+		RIPEMD160_VEC_PRC(4, 0, 1, 2, 3, w[ 9], w[ 8], 15, 12, 2);
+		RIPEMD160_VEC_PRC(3, 4, 0, 1, 2, w[ 5], w[12],  9,  7, 2);
+		RIPEMD160_VEC_PRC(2, 3, 4, 0, 1, w[ 2], w[ 4], 11,  6, 2);
+		RIPEMD160_VEC_PRC(1, 2, 3, 4, 0, w[14], w[ 9],  7, 15, 2);
+		RIPEMD160_VEC_PRC(0, 1, 2, 3, 4, w[11], w[ 1], 13, 13, 2);
+		RIPEMD160_VEC_PRC(4, 0, 1, 2, 3, w[ 8], w[ 2], 12, 11, 2);
+		
+		RIPEMD160_VEC_PRC(3, 4, 0, 1, 2, w[ 3], w[15], 11,  9, 3);
+		RIPEMD160_VEC_PRC(2, 3, 4, 0, 1, w[10], w[ 5], 13,  7, 3);
+		RIPEMD160_VEC_PRC(1, 2, 3, 4, 0, w[14], w[ 1],  6, 15, 3);
+		RIPEMD160_VEC_PRC(0, 1, 2, 3, 4, w[ 4], w[ 3],  7, 11, 3);
+		RIPEMD160_VEC_PRC(4, 0, 1, 2, 3, w[ 9], w[ 7], 14,  8, 3);
+		RIPEMD160_VEC_PRC(3, 4, 0, 1, 2, w[15], w[14],  9,  6, 3);
+		RIPEMD160_VEC_PRC(2, 3, 4, 0, 1, w[ 8], w[ 6], 13,  6, 3);
+		RIPEMD160_VEC_PRC(1, 2, 3, 4, 0, w[ 1], w[ 9], 15, 14, 3);
+		RIPEMD160_VEC_PRC(0, 1, 2, 3, 4, w[ 2], w[11], 14, 12, 3);
+		RIPEMD160_VEC_PRC(4, 0, 1, 2, 3, w[ 7], w[ 8],  8, 13, 3);
+		RIPEMD160_VEC_PRC(3, 4, 0, 1, 2, w[ 0], w[12], 13,  5, 3);
+		RIPEMD160_VEC_PRC(2, 3, 4, 0, 1, w[ 6], w[ 2],  6, 14, 3);
+		RIPEMD160_VEC_PRC(1, 2, 3, 4, 0, w[13], w[10],  5, 13, 3);
+		RIPEMD160_VEC_PRC(0, 1, 2, 3, 4, w[11], w[ 0], 12, 13, 3);
+		RIPEMD160_VEC_PRC(4, 0, 1, 2, 3, w[ 5], w[ 4],  7,  7, 3);
+		RIPEMD160_VEC_PRC(3, 4, 0, 1, 2, w[12], w[13],  5,  5, 3);
+		
+		RIPEMD160_VEC_PRC(2, 3, 4, 0, 1, w[ 1], w[ 8], 11, 15, 4);
+		RIPEMD160_VEC_PRC(1, 2, 3, 4, 0, w[ 9], w[ 6], 12,  5, 4);
+		RIPEMD160_VEC_PRC(0, 1, 2, 3, 4, w[11], w[ 4], 14,  8, 4);
+		RIPEMD160_VEC_PRC(4, 0, 1, 2, 3, w[10], w[ 1], 15, 11, 4);
+		RIPEMD160_VEC_PRC(3, 4, 0, 1, 2, w[ 0], w[ 3], 14, 14, 4);
+		RIPEMD160_VEC_PRC(2, 3, 4, 0, 1, w[ 8], w[11], 15, 14, 4);
+		RIPEMD160_VEC_PRC(1, 2, 3, 4, 0, w[12], w[15],  9,  6, 4);
+		RIPEMD160_VEC_PRC(0, 1, 2, 3, 4, w[ 4], w[ 0],  8, 14, 4);
+		RIPEMD160_VEC_PRC(4, 0, 1, 2, 3, w[13], w[ 5],  9,  6, 4);
+		RIPEMD160_VEC_PRC(3, 4, 0, 1, 2, w[ 3], w[12], 14,  9, 4);
+		RIPEMD160_VEC_PRC(2, 3, 4, 0, 1, w[ 7], w[ 2],  5, 12, 4);
+		RIPEMD160_VEC_PRC(1, 2, 3, 4, 0, w[15], w[13],  6,  9, 4);
+		RIPEMD160_VEC_PRC(0, 1, 2, 3, 4, w[14], w[ 9],  8, 12, 4);
+		RIPEMD160_VEC_PRC(4, 0, 1, 2, 3, w[ 5], w[ 7],  6,  5, 4);
+		RIPEMD160_VEC_PRC(3, 4, 0, 1, 2, w[ 6], w[10],  5, 15, 4);
+		RIPEMD160_VEC_PRC(2, 3, 4, 0, 1, w[ 2], w[14], 12,  8, 4);
+		
+		RIPEMD160_VEC_PRC(1, 2, 3, 4, 0, w[ 4], w[12],  9,  8, 5);
+		RIPEMD160_VEC_PRC(0, 1, 2, 3, 4, w[ 0], w[15], 15,  5, 5);
+		RIPEMD160_VEC_PRC(4, 0, 1, 2, 3, w[ 5], w[10],  5, 12, 5);
+		RIPEMD160_VEC_PRC(3, 4, 0, 1, 2, w[ 9], w[ 4], 11,  9, 5);
+		RIPEMD160_VEC_PRC(2, 3, 4, 0, 1, w[ 7], w[ 1],  6, 12, 5);
+		RIPEMD160_VEC_PRC(1, 2, 3, 4, 0, w[12], w[ 5],  8,  5, 5);
+		RIPEMD160_VEC_PRC(0, 1, 2, 3, 4, w[ 2], w[ 8], 13, 14, 5);
+		RIPEMD160_VEC_PRC(4, 0, 1, 2, 3, w[10], w[ 7], 12,  6, 5);
+		RIPEMD160_VEC_PRC(3, 4, 0, 1, 2, w[14], w[ 6],  5,  8, 5);
+		RIPEMD160_VEC_PRC(2, 3, 4, 0, 1, w[ 1], w[ 2], 12, 13, 5);
+		RIPEMD160_VEC_PRC(1, 2, 3, 4, 0, w[ 3], w[13], 13,  6, 5);
+		RIPEMD160_VEC_PRC(0, 1, 2, 3, 4, w[ 8], w[14], 14,  5, 5);
+		RIPEMD160_VEC_PRC(4, 0, 1, 2, 3, w[11], w[ 0], 11, 15, 5);
+		RIPEMD160_VEC_PRC(3, 4, 0, 1, 2, w[ 6], w[ 3],  8, 13, 5);
+		RIPEMD160_VEC_PRC(2, 3, 4, 0, 1, w[15], w[ 9],  5, 11, 5);
+		RIPEMD160_VEC_PRC(1, 2, 3, 4, 0, w[13], w[11],  6, 11, 5);
+		
+		RIPEMD_VEC_UNPACK(wv[0], lv, 0, 5);
+		RIPEMD_VEC_UNPACK(wv[1], lv, 1, 6);
+		RIPEMD_VEC_UNPACK(wv[2], lv, 2, 7);
+		RIPEMD_VEC_UNPACK(wv[3], lv, 3, 8);
+		RIPEMD_VEC_UNPACK(wv[4], lv, 4, 9);
+		
+		lv[8] += lv[2] + ctx->h[1];
+		ctx->h[1] = ctx->h[2] + lv[3] + lv[9];
+		ctx->h[2] = ctx->h[3] + lv[4] + lv[5];
+		ctx->h[3] = ctx->h[4] + lv[0] + lv[6];
+		ctx->h[4] = ctx->h[0] + lv[1] + lv[7];
+		ctx->h[0] = lv[8];
+	}
+}
+
+#endif
@@ -19,7 +19,10 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <sys/uio.h>
+
 #include "ampheck.h"
+#include "backends.h"
 #include "sha0.h"
 
 #define SHA0_R1(x, y, z) ((z ^ (x & (y ^ z)))       + 0x5a827999)
@@ -45,9 +48,10 @@ void ampheck_sha0_init(struct ampheck_sha0 *ctx)
 	ctx->h[4] = 0xc3d2e1f0;
 	
 	ctx->length = 0;
+	ctx->fill = 0;
 }
 
-void ampheck_sha0_transform(struct ampheck_sha0 *ctx, const uint8_t *data, size_t blocks)
+void ampheck_sha0_transform_generic(struct ampheck_sha0 *ctx, const uint8_t *data, size_t blocks)
 {
 	for (size_t i = 0; i < blocks; ++i)
 	{
@@ -169,60 +173,128 @@ void ampheck_sha0_transform(struct ampheck_sha0 *ctx, const uint8_t *data, size_
 	}
 }
 
-void ampheck_sha0_update(struct ampheck_sha0 *ctx, const uint8_t *data, size_t size)
+const struct ampheck_backend ampheck_sha0_backends[] =
+{
+#ifdef AMPHECK_X86
+	{ "shani", AMPHECK_CPU_SHA | AMPHECK_CPU_SSE41, (ampheck_backend_fn) ampheck_sha0_transform_shani },
+#endif
+	{ "generic", 0, (ampheck_backend_fn) ampheck_sha0_transform_generic },
+	{ NULL, 0, NULL }
+};
+
+void ampheck_sha0_transform(struct ampheck_sha0 *ctx, const uint8_t *data, size_t blocks)
 {
-	size_t tmp = size;
+	static void (*transform)(struct ampheck_sha0 *, const uint8_t *, size_t) = NULL;
+	void (*selected)(struct ampheck_sha0 *, const uint8_t *, size_t) = AMPHECK_LOAD(transform);
 	
-	if (size >= 64 - ctx->length % 64)
+	if (selected == NULL)
+	{
+		selected = (void (*)(struct ampheck_sha0 *, const uint8_t *, size_t)) ampheck_backend_select("sha0", ampheck_sha0_backends)->transform;
+		AMPHECK_STORE(transform, selected);
+	}
+	
+	selected(ctx, data, blocks);
+}
+
+static void __attribute__((noinline)) sha0_update_blocks(struct ampheck_sha0 *ctx, const uint8_t *data, size_t size)
+{
+	if (ctx->fill > 0)
 	{
-		memcpy(&ctx->buffer[ctx->length % 64], data, 64 - ctx->length % 64);
+		memcpy(&ctx->buffer[ctx->fill], data, 64 - ctx->fill);
 		
-		data += 64 - ctx->length % 64;
-		size -= 64 - ctx->length % 64;
+		data += 64 - ctx->fill;
+		size -= 64 - ctx->fill;
 		
 		ampheck_sha0_transform(ctx, ctx->buffer, 1);
-		ampheck_sha0_transform(ctx, data, size / 64);
-		
-		data += size & ~63;
-		size %= 64;
+	}
+	
+	ampheck_sha0_transform(ctx, data, size / 64);
+	
+	data += size & ~(size_t) 63;
+	ctx->fill = (uint32_t) (size % 64);
+	
+	memcpy(ctx->buffer, data, ctx->fill);
+}
+
+void ampheck_sha0_update(struct ampheck_sha0 *ctx, const uint8_t *data, size_t size)
+{
+	ctx->length += size;
+	
+	if (size < 64 - ctx->fill)
+	{
+		uint8_t *p = &ctx->buffer[ctx->fill];
 		
-		memcpy(ctx->buffer, data, size);
+		ctx->fill += (uint32_t) size;
+		memcpy(p, data, size);
 	}
 	else
 	{
-		memcpy(&ctx->buffer[ctx->length % 64], data, size);
+		sha0_update_blocks(ctx, data, size);
+	}
+}
+
+void ampheck_sha0_updatev(struct ampheck_sha0 *ctx, const struct iovec *iov, int iovcnt)
+{
+	for (int i = 0; i < iovcnt; ++i)
+	{
+		ampheck_sha0_update(ctx, iov[i].iov_base, iov[i].iov_len);
 	}
-	
-	ctx->length += tmp;
 }
 
 void ampheck_sha0_finish(const struct ampheck_sha0 *ctx, uint8_t *digest)
 {
 	struct ampheck_sha0 tmp;
 	
-	memcpy(tmp.h, ctx->h, 5 * sizeof(uint32_t));
-	memcpy(tmp.buffer, ctx->buffer, ctx->length % 64);
+	memcpy(tmp.h, ctx->h, sizeof(tmp.h));
+	memcpy(tmp.buffer, ctx->buffer, ctx->fill);
+	tmp.length = ctx->length;
+	tmp.fill = ctx->fill;
 	
-	tmp.buffer[ctx->length % 64] = 0x80;
+	ampheck_sha0_finish_inplace(&tmp, digest);
+}
+
+void ampheck_sha0_finish_inplace(struct ampheck_sha0 *ctx, uint8_t *digest)
+{
+	ctx->buffer[ctx->fill] = 0x80;
 	
-	if (ctx->length % 64 < 56)
+	if (ctx->fill < 56)
 	{
-		memset(&tmp.buffer[ctx->length % 64 + 1], 0x00, 55 - ctx->length % 64);
+		memset(&ctx->buffer[ctx->fill + 1], 0x00, 55 - ctx->fill);
 	}
 	else
 	{
-		memset(&tmp.buffer[ctx->length % 64 + 1], 0x00, 63 - ctx->length % 64);
-		ampheck_sha0_transform(&tmp, tmp.buffer, 1);
+		memset(&ctx->buffer[ctx->fill + 1], 0x00, 63 - ctx->fill);
+		ampheck_sha0_transform(ctx, ctx->buffer, 1);
 		
-		memset(tmp.buffer, 0x00, 56);
+		memset(ctx->buffer, 0x00, 56);
 	}
 	
-	UNPACK_64_BE(ctx->length * 8, &tmp.buffer[56]);
-	ampheck_sha0_transform(&tmp, tmp.buffer, 1);
+	UNPACK_64_BE(ctx->length * 8, &ctx->buffer[56]);
+	ampheck_sha0_transform(ctx, ctx->buffer, 1);
 	
-	UNPACK_32_BE(tmp.h[0], &digest[ 0]);
-	UNPACK_32_BE(tmp.h[1], &digest[ 4]);
-	UNPACK_32_BE(tmp.h[2], &digest[ 8]);
-	UNPACK_32_BE(tmp.h[3], &digest[12]);
-	UNPACK_32_BE(tmp.h[4], &digest[16]);
+	UNPACK_32_BE(ctx->h[0], &digest[ 0]);
+	UNPACK_32_BE(ctx->h[1], &digest[ 4]);
+	UNPACK_32_BE(ctx->h[2], &digest[ 8]);
+	UNPACK_32_BE(ctx->h[3], &digest[12]);
+	UNPACK_32_BE(ctx->h[4], &digest[16]);
+}
+
+void ampheck_sha0_digest(const uint8_t *data, size_t length, uint8_t *digest)
+{
+	struct ampheck_sha0 ctx;
+	uint8_t final[128];
+	
+	ampheck_sha0_init(&ctx);
+	
+	if (length >= 64)
+	{
+		ampheck_sha0_transform(&ctx, data, length / 64);
+	}
+	
+	ampheck_sha0_transform(&ctx, final, ampheck_final(final, &data[length & ~(size_t) 63], length, 64, 1));
+	
+	for (int j = 0; j < 5; ++j)
+	{
+		UNPACK_32_BE(ctx.h[j], &digest[j * 4]);
+	}
 }
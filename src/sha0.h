@@ -21,16 +21,24 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "align.h"
+
+struct iovec;
+
 struct ampheck_sha0
 {
 	uint32_t h[5];
-	uint8_t buffer[64];
-	
 	uint64_t length;
+	uint32_t fill;
+	
+	AMPHECK_ALIGNED(64) uint8_t buffer[64];
 };
 
 void ampheck_sha0_init(struct ampheck_sha0 *ctx);
 void ampheck_sha0_update(struct ampheck_sha0 *ctx, const uint8_t *data, size_t length);
+void ampheck_sha0_updatev(struct ampheck_sha0 *ctx, const struct iovec *iov, int iovcnt);
 void ampheck_sha0_finish(const struct ampheck_sha0 *ctx, uint8_t *digest);
+void ampheck_sha0_finish_inplace(struct ampheck_sha0 *ctx, uint8_t *digest);
+void ampheck_sha0_digest(const uint8_t *data, size_t length, uint8_t *digest);
 
 #endif
@@ -21,16 +21,31 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "align.h"
+#include "mgr.h"
+
+struct iovec;
+
 struct ampheck_sha1
 {
 	uint32_t h[5];
-	uint8_t buffer[64];
-	
 	uint64_t length;
+	uint32_t fill;
+	
+	AMPHECK_ALIGNED(64) uint8_t buffer[64];
 };
 
 void ampheck_sha1_init(struct ampheck_sha1 *ctx);
 void ampheck_sha1_update(struct ampheck_sha1 *ctx, const uint8_t *data, size_t length);
+void ampheck_sha1_updatev(struct ampheck_sha1 *ctx, const struct iovec *iov, int iovcnt);
 void ampheck_sha1_finish(const struct ampheck_sha1 *ctx, uint8_t *digest);
+void ampheck_sha1_finish_inplace(struct ampheck_sha1 *ctx, uint8_t *digest);
+void ampheck_sha1_digest(const uint8_t *data, size_t length, uint8_t *digest);
+
+/* Batch versions over arrays of contexts; see sha256.h. */
+void ampheck_sha1_init_batch(struct ampheck_sha1 *ctx, size_t count);
+void ampheck_sha1_update_batch(struct ampheck_sha1 *ctx, const uint8_t *const data[], const size_t length[], size_t count);
+void ampheck_sha1_finish_batch(const struct ampheck_sha1 *ctx, uint8_t *const digest[], size_t count);
+void ampheck_sha1_mgr_init(struct ampheck_mgr *mgr);
 
 #endif
@@ -0,0 +1,179 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "backends.h"
+#include "lanes.h"
+#include "sha1.h"
+
+#ifdef AMPHECK_X86
+
+/*
+	Eight (AVX2) or sixteen (AVX-512) SHA-1 messages side by side, one per
+	32-bit lane.  The schedule is expanded in a ring of sixteen words as the
+	rounds consume it.
+*/
+
+#define SHA1_LANES_EXT(t) ( \
+	w[(t) & 0x0F] = ROL(XOR4(w[((t) - 3) & 0x0F], w[((t) - 8) & 0x0F], w[((t) - 14) & 0x0F], w[(t) & 0x0F]), 1) \
+)
+
+#define SHA1_LANES_PRC(a, b, c, d, e, t, rnd) { \
+	if ((t) >= 16) \
+	{ \
+		SHA1_LANES_EXT(t); \
+	} \
+	\
+	wv[e] = ADD(ADD(wv[e], ROL(wv[a], 5)), ADD(SHA1_R##rnd(wv[b], wv[c], wv[d]), w[(t) & 0x0F])); \
+	wv[b] = ROL(wv[b], 30); \
+}
+
+#define SHA1_LANES_RND(t, rnd) { \
+	SHA1_LANES_PRC(0, 1, 2, 3, 4, (t)    , rnd); \
+	SHA1_LANES_PRC(4, 0, 1, 2, 3, (t) + 1, rnd); \
+	SHA1_LANES_PRC(3, 4, 0, 1, 2, (t) + 2, rnd); \
+	SHA1_LANES_PRC(2, 3, 4, 0, 1, (t) + 3, rnd); \
+	SHA1_LANES_PRC(1, 2, 3, 4, 0, (t) + 4, rnd); \
+}
+
+#define SHA1_LANES_BLOCK() { \
+	for (int j = 0; j < 5; ++j) \
+	{ \
+		wv[j] = s[j]; \
+	} \
+	\
+	SHA1_LANES_RND( 0, 1); SHA1_LANES_RND( 5, 1); SHA1_LANES_RND(10, 1); SHA1_LANES_RND(15, 1); \
+	SHA1_LANES_RND(20, 2); SHA1_LANES_RND(25, 2); SHA1_LANES_RND(30, 2); SHA1_LANES_RND(35, 2); \
+	SHA1_LANES_RND(40, 3); SHA1_LANES_RND(45, 3); SHA1_LANES_RND(50, 3); SHA1_LANES_RND(55, 3); \
+	SHA1_LANES_RND(60, 4); SHA1_LANES_RND(65, 4); SHA1_LANES_RND(70, 4); SHA1_LANES_RND(75, 4); \
+	\
+	for (int j = 0; j < 5; ++j) \
+	{ \
+		s[j] = ADD(s[j], wv[j]); \
+	} \
+}
+
+#define ADD(x, y) _mm256_add_epi32(x, y)
+#define SET1(x) _mm256_set1_epi32((int) (x))
+#define ROL(x, y) _mm256_or_si256(_mm256_slli_epi32(x, y), _mm256_srli_epi32(x, 32 - (y)))
+#define XOR3(x, y, z) _mm256_xor_si256(_mm256_xor_si256(x, y), z)
+#define XOR4(w, x, y, z) _mm256_xor_si256(_mm256_xor_si256(w, x), _mm256_xor_si256(y, z))
+#define CH(x, y, z) _mm256_xor_si256(z, _mm256_and_si256(x, _mm256_xor_si256(y, z)))
+#define MAJ(x, y, z) _mm256_or_si256(_mm256_and_si256(x, y), _mm256_and_si256(z, _mm256_or_si256(x, y)))
+
+#define SHA1_R1(x, y, z) ADD(CH(x, y, z),   SET1(0x5a827999))
+#define SHA1_R2(x, y, z) ADD(XOR3(x, y, z), SET1(0x6ed9eba1))
+#define SHA1_R3(x, y, z) ADD(MAJ(x, y, z),  SET1(0x8f1bbcdc))
+#define SHA1_R4(x, y, z) ADD(XOR3(x, y, z), SET1(0xca62c1d6))
+
+__attribute__((target("avx2")))
+void ampheck_sha1_lanes_avx2(void *state, const uint8_t *const data[], size_t blocks)
+{
+	const __m256i mask = _mm256_set_epi8(12, 13, 14, 15,  8,  9, 10, 11,  4,  5,  6,  7,  0,  1,  2,  3,
+	                                     12, 13, 14, 15,  8,  9, 10, 11,  4,  5,  6,  7,  0,  1,  2,  3);
+	__m256i *h = state;
+	__m256i s[5];
+	
+	for (int j = 0; j < 5; ++j)
+	{
+		s[j] = _mm256_loadu_si256(&h[j]);
+	}
+	
+	for (size_t i = 0; i < blocks; ++i)
+	{
+		__m256i wv[5];
+		__m256i w[16];
+		
+		for (int j = 0; j < 8; ++j)
+		{
+			w[j    ] = _mm256_loadu_si256((const __m256i *) &data[j][(i << 6)     ]);
+			w[j + 8] = _mm256_loadu_si256((const __m256i *) &data[j][(i << 6) + 32]);
+		}
+		
+		ampheck_transpose8(&w[0]);
+		ampheck_transpose8(&w[8]);
+		
+		for (int j = 0; j < 16; ++j)
+		{
+			w[j] = _mm256_shuffle_epi8(w[j], mask);
+		}
+		
+		SHA1_LANES_BLOCK();
+	}
+	
+	for (int j = 0; j < 5; ++j)
+	{
+		_mm256_storeu_si256(&h[j], s[j]);
+	}
+}
+
+#undef ADD
+#undef SET1
+#undef ROL
+#undef XOR3
+#undef XOR4
+#undef CH
+#undef MAJ
+
+#define ADD(x, y) _mm512_add_epi32(x, y)
+#define SET1(x) _mm512_set1_epi32((int) (x))
+#define ROL(x, y) _mm512_rol_epi32(x, y)
+#define XOR3(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0x96)
+#define XOR4(w, x, y, z) _mm512_ternarylogic_epi32(w, x, _mm512_xor_si512(y, z), 0x96)
+#define CH(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0xCA)
+#define MAJ(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0xE8)
+
+__attribute__((target("avx512f")))
+void ampheck_sha1_lanes_avx512(void *state, const uint8_t *const data[], size_t blocks)
+{
+	__m512i *h = state;
+	__m512i s[5];
+	
+	for (int j = 0; j < 5; ++j)
+	{
+		s[j] = _mm512_loadu_si512(&h[j]);
+	}
+	
+	for (size_t i = 0; i < blocks; ++i)
+	{
+		__m512i wv[5];
+		__m512i w[16];
+		
+		for (int j = 0; j < 16; ++j)
+		{
+			w[j] = _mm512_loadu_si512(&data[j][i << 6]);
+		}
+		
+		ampheck_transpose16(w);
+		
+		for (int j = 0; j < 16; ++j)
+		{
+			w[j] = ampheck_bswap32_avx512(w[j]);
+		}
+		
+		SHA1_LANES_BLOCK();
+	}
+	
+	for (int j = 0; j < 5; ++j)
+	{
+		_mm512_storeu_si512(&h[j], s[j]);
+	}
+}
+
+#endif
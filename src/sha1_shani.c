@@ -0,0 +1,127 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "backends.h"
+#include "sha0.h"
+#include "sha1.h"
+
+#ifdef AMPHECK_X86
+
+#include <immintrin.h>
+
+/*
+	SHA-0 and SHA-1 share everything but the rotate in the message schedule.
+	sha1msg1 only XORs, so both use it; sha1msg2 rotates, so SHA-0 finishes
+	its words with plain shifts and XORs instead.
+*/
+
+#define SHA1_NI_RND(e0, e1, cur, fn) { \
+	e0 = _mm_sha1nexte_epu32(e0, cur); \
+	e1 = abcd; \
+	abcd = _mm_sha1rnds4_epu32(abcd, e0, fn); \
+}
+
+#define SHA1_NI_MSG1(cur, prev) { \
+	prev = _mm_sha1msg1_epu32(prev, cur); \
+}
+
+#define SHA1_NI_XOR(cur, next) { \
+	next = _mm_xor_si128(next, cur); \
+}
+
+#define SHA1_NI_MSG2(cur, next) { \
+	if (sha0) \
+	{ \
+		next = _mm_xor_si128(next, _mm_slli_si128(cur, 4)); \
+		next = _mm_xor_si128(next, _mm_srli_si128(next, 12)); \
+	} \
+	else \
+	{ \
+		next = _mm_sha1msg2_epu32(next, cur); \
+	} \
+}
+
+__attribute__((target("sha,sse4.1"), always_inline))
+static inline void sha1_shani(uint32_t *h, const uint8_t *data, size_t blocks, int sha0)
+{
+	const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+	__m128i abcd, e0, e1;
+	__m128i m0, m1, m2, m3;
+	
+	abcd = _mm_loadu_si128((const __m128i *) h);
+	abcd = _mm_shuffle_epi32(abcd, 0x1B);
+	e0   = _mm_set_epi32(h[4], 0, 0, 0);
+	
+	for (size_t i = 0; i < blocks; ++i)
+	{
+		const __m128i abcd_save = abcd;
+		const __m128i e0_save = e0;
+		
+		m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) &data[(i << 6)     ]), mask);
+		m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) &data[(i << 6) + 16]), mask);
+		m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) &data[(i << 6) + 32]), mask);
+		m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) &data[(i << 6) + 48]), mask);
+		
+		e0 = _mm_add_epi32(e0, m0);
+		e1 = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+		
+		SHA1_NI_RND(e1, e0, m1, 0);                                                      SHA1_NI_MSG1(m1, m0);
+		SHA1_NI_RND(e0, e1, m2, 0);                            SHA1_NI_XOR(m2, m0);     SHA1_NI_MSG1(m2, m1);
+		SHA1_NI_MSG2(m3, m0); SHA1_NI_RND(e1, e0, m3, 0);     SHA1_NI_XOR(m3, m1);     SHA1_NI_MSG1(m3, m2);
+		SHA1_NI_MSG2(m0, m1); SHA1_NI_RND(e0, e1, m0, 0);     SHA1_NI_XOR(m0, m2);     SHA1_NI_MSG1(m0, m3);
+		SHA1_NI_MSG2(m1, m2); SHA1_NI_RND(e1, e0, m1, 1);     SHA1_NI_XOR(m1, m3);     SHA1_NI_MSG1(m1, m0);
+		SHA1_NI_MSG2(m2, m3); SHA1_NI_RND(e0, e1, m2, 1);     SHA1_NI_XOR(m2, m0);     SHA1_NI_MSG1(m2, m1);
+		SHA1_NI_MSG2(m3, m0); SHA1_NI_RND(e1, e0, m3, 1);     SHA1_NI_XOR(m3, m1);     SHA1_NI_MSG1(m3, m2);
+		SHA1_NI_MSG2(m0, m1); SHA1_NI_RND(e0, e1, m0, 1);     SHA1_NI_XOR(m0, m2);     SHA1_NI_MSG1(m0, m3);
+		SHA1_NI_MSG2(m1, m2); SHA1_NI_RND(e1, e0, m1, 1);     SHA1_NI_XOR(m1, m3);     SHA1_NI_MSG1(m1, m0);
+		SHA1_NI_MSG2(m2, m3); SHA1_NI_RND(e0, e1, m2, 2);     SHA1_NI_XOR(m2, m0);     SHA1_NI_MSG1(m2, m1);
+		SHA1_NI_MSG2(m3, m0); SHA1_NI_RND(e1, e0, m3, 2);     SHA1_NI_XOR(m3, m1);     SHA1_NI_MSG1(m3, m2);
+		SHA1_NI_MSG2(m0, m1); SHA1_NI_RND(e0, e1, m0, 2);     SHA1_NI_XOR(m0, m2);     SHA1_NI_MSG1(m0, m3);
+		SHA1_NI_MSG2(m1, m2); SHA1_NI_RND(e1, e0, m1, 2);     SHA1_NI_XOR(m1, m3);     SHA1_NI_MSG1(m1, m0);
+		SHA1_NI_MSG2(m2, m3); SHA1_NI_RND(e0, e1, m2, 2);     SHA1_NI_XOR(m2, m0);     SHA1_NI_MSG1(m2, m1);
+		SHA1_NI_MSG2(m3, m0); SHA1_NI_RND(e1, e0, m3, 3);     SHA1_NI_XOR(m3, m1);     SHA1_NI_MSG1(m3, m2);
+		SHA1_NI_MSG2(m0, m1); SHA1_NI_RND(e0, e1, m0, 3);     SHA1_NI_XOR(m0, m2);     SHA1_NI_MSG1(m0, m3);
+		SHA1_NI_MSG2(m1, m2); SHA1_NI_RND(e1, e0, m1, 3);     SHA1_NI_XOR(m1, m3);
+		SHA1_NI_MSG2(m2, m3); SHA1_NI_RND(e0, e1, m2, 3);
+		                      SHA1_NI_RND(e1, e0, m3, 3);
+		
+		e0 = _mm_sha1nexte_epu32(e0, e0_save);
+		abcd = _mm_add_epi32(abcd, abcd_save);
+	}
+	
+	abcd = _mm_shuffle_epi32(abcd, 0x1B);
+	_mm_storeu_si128((__m128i *) h, abcd);
+	h[4] = (uint32_t) _mm_extract_epi32(e0, 3);
+}
+
+__attribute__((target("sha,sse4.1")))
+void ampheck_sha0_transform_shani(struct ampheck_sha0 *ctx, const uint8_t *data, size_t blocks)
+{
+	sha1_shani(ctx->h, data, blocks, 1);
+}
+
+__attribute__((target("sha,sse4.1")))
+void ampheck_sha1_transform_shani(struct ampheck_sha1 *ctx, const uint8_t *data, size_t blocks)
+{
+	sha1_shani(ctx->h, data, blocks, 0);
+}
+
+#endif
@@ -0,0 +1,208 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ampheck.h"
+#include "backends.h"
+#include "sha1.h"
+
+#ifdef AMPHECK_X86
+
+#include <immintrin.h>
+
+/*
+	W+K is precomputed four words at a time.  Only the last word of each
+	group depends on another word of the same group, so it is computed with
+	that word taken as zero and fixed up afterwards.  The AVX2 kernel does
+	the same for two blocks at once, one in each 128-bit half.
+*/
+
+#define SHA1_F1(x, y, z) (z ^ (x & (y ^ z)))
+#define SHA1_F2(x, y, z) (x ^ y ^ z)
+#define SHA1_F3(x, y, z) ((x & y) | (z & (x | y)))
+#define SHA1_F4(x, y, z) (x ^ y ^ z)
+
+#define SHA1_PRC(a, b, c, d, e, wk, rnd) { \
+	wv[e] += ROR(wv[a], 27) + SHA1_F##rnd(wv[b], wv[c], wv[d]) + wk; \
+	wv[b]  = ROR(wv[b], 2); \
+}
+
+#define SHA1_PHASE(t, rnd) { \
+	for (size_t j = t; j < t + 20; j += 5) \
+	{ \
+		SHA1_PRC(0, 1, 2, 3, 4, wk[j    ], rnd); \
+		SHA1_PRC(4, 0, 1, 2, 3, wk[j + 1], rnd); \
+		SHA1_PRC(3, 4, 0, 1, 2, wk[j + 2], rnd); \
+		SHA1_PRC(2, 3, 4, 0, 1, wk[j + 3], rnd); \
+		SHA1_PRC(1, 2, 3, 4, 0, wk[j + 4], rnd); \
+	} \
+}
+
+#define SHA1_SSSE3_ROL(x, y) _mm_or_si128(_mm_slli_epi32(x, y), _mm_srli_epi32(x, 32 - (y)))
+#define SHA1_AVX2_ROL(x, y) _mm256_or_si256(_mm256_slli_epi32(x, y), _mm256_srli_epi32(x, 32 - (y)))
+
+#define SHA1_SSSE3_EXT(x0, x1, x2, x3, g) { \
+	x0 = sha1_ssse3_ext(x0, x1, x2, x3); \
+	_mm_store_si128((__m128i *) &wk[(g) << 2], _mm_add_epi32(x0, _mm_set1_epi32(sha1_k[(g) / 5]))); \
+}
+
+#define SHA1_AVX2_EXT(x0, x1, x2, x3, g) { \
+	x0 = sha1_avx2_ext(x0, x1, x2, x3); \
+	SHA1_AVX2_STORE(x0, g); \
+}
+
+#define SHA1_AVX2_STORE(x, g) { \
+	__m256i k = _mm256_add_epi32(x, _mm256_set1_epi32(sha1_k[(g) / 5])); \
+	_mm_store_si128((__m128i *) &wk[0][(g) << 2], _mm256_castsi256_si128(k)); \
+	_mm_store_si128((__m128i *) &wk[1][(g) << 2], _mm256_extracti128_si256(k, 1)); \
+}
+
+static const uint32_t sha1_k[4] =
+{
+	0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xca62c1d6
+};
+
+__attribute__((always_inline))
+static inline void sha1_rounds(uint32_t *h, const uint32_t *wk)
+{
+	uint32_t wv[5];
+	
+	wv[0] = h[0];
+	wv[1] = h[1];
+	wv[2] = h[2];
+	wv[3] = h[3];
+	wv[4] = h[4];
+	
+	SHA1_PHASE( 0, 1);
+	SHA1_PHASE(20, 2);
+	SHA1_PHASE(40, 3);
+	SHA1_PHASE(60, 4);
+	
+	h[0] += wv[0];
+	h[1] += wv[1];
+	h[2] += wv[2];
+	h[3] += wv[3];
+	h[4] += wv[4];
+}
+
+/* Computes W[t..t+3] from W[t-16..t-1]. */
+__attribute__((target("ssse3"), always_inline))
+static inline __m128i sha1_ssse3_ext(__m128i x0, __m128i x1, __m128i x2, __m128i x3)
+{
+	__m128i t;
+	
+	t = _mm_xor_si128(_mm_alignr_epi8(x1, x0, 8), x0);
+	t = _mm_xor_si128(t, x2);
+	t = _mm_xor_si128(t, _mm_srli_si128(x3, 4));
+	t = SHA1_SSSE3_ROL(t, 1);
+	
+	return _mm_xor_si128(t, SHA1_SSSE3_ROL(_mm_slli_si128(t, 12), 1));
+}
+
+__attribute__((target("avx2"), always_inline))
+static inline __m256i sha1_avx2_ext(__m256i x0, __m256i x1, __m256i x2, __m256i x3)
+{
+	__m256i t;
+	
+	t = _mm256_xor_si256(_mm256_alignr_epi8(x1, x0, 8), x0);
+	t = _mm256_xor_si256(t, x2);
+	t = _mm256_xor_si256(t, _mm256_srli_si256(x3, 4));
+	t = SHA1_AVX2_ROL(t, 1);
+	
+	return _mm256_xor_si256(t, SHA1_AVX2_ROL(_mm256_slli_si256(t, 12), 1));
+}
+
+__attribute__((target("ssse3")))
+void ampheck_sha1_transform_ssse3(struct ampheck_sha1 *ctx, const uint8_t *data, size_t blocks)
+{
+	const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+	uint32_t wk[80] __attribute__((aligned(16)));
+	
+	for (size_t i = 0; i < blocks; ++i)
+	{
+		__m128i x0, x1, x2, x3;
+		
+		x0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) &data[(i << 6)     ]), mask);
+		x1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) &data[(i << 6) + 16]), mask);
+		x2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) &data[(i << 6) + 32]), mask);
+		x3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) &data[(i << 6) + 48]), mask);
+		
+		_mm_store_si128((__m128i *) &wk[ 0], _mm_add_epi32(x0, _mm_set1_epi32(sha1_k[0])));
+		_mm_store_si128((__m128i *) &wk[ 4], _mm_add_epi32(x1, _mm_set1_epi32(sha1_k[0])));
+		_mm_store_si128((__m128i *) &wk[ 8], _mm_add_epi32(x2, _mm_set1_epi32(sha1_k[0])));
+		_mm_store_si128((__m128i *) &wk[12], _mm_add_epi32(x3, _mm_set1_epi32(sha1_k[0])));
+		
+		for (size_t g = 4; g < 20; g += 4)
+		{
+			SHA1_SSSE3_EXT(x0, x1, x2, x3, g    );
+			SHA1_SSSE3_EXT(x1, x2, x3, x0, g + 1);
+			SHA1_SSSE3_EXT(x2, x3, x0, x1, g + 2);
+			SHA1_SSSE3_EXT(x3, x0, x1, x2, g + 3);
+		}
+		
+		sha1_rounds(ctx->h, wk);
+	}
+}
+
+__attribute__((target("avx2,bmi2")))
+void ampheck_sha1_transform_avx2(struct ampheck_sha1 *ctx, const uint8_t *data, size_t blocks)
+{
+	const __m256i mask = _mm256_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL,
+	                                       0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+	uint32_t wk[2][80] __attribute__((aligned(16)));
+	
+	for (size_t i = 0; i < blocks; i += 2)
+	{
+		const uint8_t *lo = &data[i << 6];
+		const uint8_t *hi = i + 1 < blocks ? lo + 64 : lo;
+		__m256i x0, x1, x2, x3;
+		
+		x0 = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *) &lo[ 0])), _mm_loadu_si128((const __m128i *) &hi[ 0]), 1);
+		x1 = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *) &lo[16])), _mm_loadu_si128((const __m128i *) &hi[16]), 1);
+		x2 = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *) &lo[32])), _mm_loadu_si128((const __m128i *) &hi[32]), 1);
+		x3 = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *) &lo[48])), _mm_loadu_si128((const __m128i *) &hi[48]), 1);
+		
+		x0 = _mm256_shuffle_epi8(x0, mask);
+		x1 = _mm256_shuffle_epi8(x1, mask);
+		x2 = _mm256_shuffle_epi8(x2, mask);
+		x3 = _mm256_shuffle_epi8(x3, mask);
+		
+		SHA1_AVX2_STORE(x0, 0);
+		SHA1_AVX2_STORE(x1, 1);
+		SHA1_AVX2_STORE(x2, 2);
+		SHA1_AVX2_STORE(x3, 3);
+		
+		for (size_t g = 4; g < 20; g += 4)
+		{
+			SHA1_AVX2_EXT(x0, x1, x2, x3, g    );
+			SHA1_AVX2_EXT(x1, x2, x3, x0, g + 1);
+			SHA1_AVX2_EXT(x2, x3, x0, x1, g + 2);
+			SHA1_AVX2_EXT(x3, x0, x1, x2, g + 3);
+		}
+		
+		sha1_rounds(ctx->h, wk[0]);
+		
+		if (i + 1 < blocks)
+		{
+			sha1_rounds(ctx->h, wk[1]);
+		}
+	}
+}
+
+#endif
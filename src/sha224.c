@@ -19,49 +19,72 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <sys/uio.h>
+
 #include "ampheck.h"
+#include "backends.h"
 #include "sha224.h"
 #include "sha256.h"
 
 void ampheck_sha224_init(struct ampheck_sha224 *ctx)
 {
-	ctx->h[0] = 0xc1059ed8;
-	ctx->h[1] = 0x367cd507;
-	ctx->h[2] = 0x3070dd17;
-	ctx->h[3] = 0xf70e5939;
-	ctx->h[4] = 0xffc00b31;
-	ctx->h[5] = 0x68581511;
-	ctx->h[6] = 0x64f98fa7;
-	ctx->h[7] = 0xbefa4fa4;
+	ctx->sha256.h[0] = 0xc1059ed8;
+	ctx->sha256.h[1] = 0x367cd507;
+	ctx->sha256.h[2] = 0x3070dd17;
+	ctx->sha256.h[3] = 0xf70e5939;
+	ctx->sha256.h[4] = 0xffc00b31;
+	ctx->sha256.h[5] = 0x68581511;
+	ctx->sha256.h[6] = 0x64f98fa7;
+	ctx->sha256.h[7] = 0xbefa4fa4;
 	
-	ctx->length = 0;
+	ctx->sha256.length = 0;
+	ctx->sha256.fill = 0;
 }
 
 void ampheck_sha224_update(struct ampheck_sha224 *ctx, const uint8_t *data, size_t size)
 {
-	struct ampheck_sha256 context;
-	
-	memcpy(context.h,      ctx->h,       8 * sizeof(uint32_t));
-	memcpy(context.buffer, ctx->buffer, 64 * sizeof(uint8_t));
-	context.length = ctx->length;
-	
-	ampheck_sha256_update(&context, data, size);
-	
-	memcpy(ctx->h,      context.h,       8 * sizeof(uint32_t));
-	memcpy(ctx->buffer, context.buffer, 64 * sizeof(uint8_t));
-	ctx->length = context.length;
+	ampheck_sha256_update(&ctx->sha256, data, size);
+}
+
+void ampheck_sha224_updatev(struct ampheck_sha224 *ctx, const struct iovec *iov, int iovcnt)
+{
+	ampheck_sha256_updatev(&ctx->sha256, iov, iovcnt);
 }
 
 void ampheck_sha224_finish(const struct ampheck_sha224 *ctx, uint8_t *digest)
 {
 	uint8_t final[32];
-	struct ampheck_sha256 context;
 	
-	memcpy(context.h,      ctx->h,       8 * sizeof(uint32_t));
-	memcpy(context.buffer, ctx->buffer, 64 * sizeof(uint8_t));
-	context.length = ctx->length;
+	ampheck_sha256_finish(&ctx->sha256, final);
+	
+	memcpy(digest, final, 28);
+}
+
+void ampheck_sha224_finish_inplace(struct ampheck_sha224 *ctx, uint8_t *digest)
+{
+	uint8_t final[32];
 	
-	ampheck_sha256_finish(&context, final);
+	ampheck_sha256_finish_inplace(&ctx->sha256, final);
 	
 	memcpy(digest, final, 28);
 }
+
+void ampheck_sha224_digest(const uint8_t *data, size_t length, uint8_t *digest)
+{
+	struct ampheck_sha224 ctx;
+	uint8_t final[128];
+	
+	ampheck_sha224_init(&ctx);
+	
+	if (length >= 64)
+	{
+		ampheck_sha256_transform(&ctx.sha256, data, length / 64);
+	}
+	
+	ampheck_sha256_transform(&ctx.sha256, final, ampheck_final(final, &data[length & ~(size_t) 63], length, 64, 1));
+	
+	for (int j = 0; j < 7; ++j)
+	{
+		UNPACK_32_BE(ctx.sha256.h[j], &digest[j * 4]);
+	}
+}
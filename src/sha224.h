@@ -21,16 +21,21 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "sha256.h"
+
+struct iovec;
+
+/* SHA-256 with another IV and a shorter digest, on the same context. */
 struct ampheck_sha224
 {
-	uint32_t h[8];
-	uint8_t buffer[64];
-	
-	uint64_t length;
+	struct ampheck_sha256 sha256;
 };
 
 void ampheck_sha224_init(struct ampheck_sha224 *ctx);
 void ampheck_sha224_update(struct ampheck_sha224 *ctx, const uint8_t *data, size_t length);
+void ampheck_sha224_updatev(struct ampheck_sha224 *ctx, const struct iovec *iov, int iovcnt);
 void ampheck_sha224_finish(const struct ampheck_sha224 *ctx, uint8_t *digest);
+void ampheck_sha224_finish_inplace(struct ampheck_sha224 *ctx, uint8_t *digest);
+void ampheck_sha224_digest(const uint8_t *data, size_t length, uint8_t *digest);
 
 #endif
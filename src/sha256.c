@@ -19,7 +19,10 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <sys/uio.h>
+
 #include "ampheck.h"
+#include "backends.h"
 #include "sha256.h"
 
 #define CH(x, y, z) (z ^ (x & (y ^ z)))
@@ -40,21 +43,20 @@
 	w[i] += SHA256_S0(w[(i + 1) & 0x0F]) + SHA256_S1(w[(i - 2) & 0x0F]) + w[(i - 7) & 0x0F] \
 )
 
+const uint32_t ampheck_sha256_iv[8] =
+{
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
 void ampheck_sha256_init(struct ampheck_sha256 *ctx)
 {
-	ctx->h[0] = 0x6a09e667;
-	ctx->h[1] = 0xbb67ae85;
-	ctx->h[2] = 0x3c6ef372;
-	ctx->h[3] = 0xa54ff53a;
-	ctx->h[4] = 0x510e527f;
-	ctx->h[5] = 0x9b05688c;
-	ctx->h[6] = 0x1f83d9ab;
-	ctx->h[7] = 0x5be0cd19;
+	memcpy(ctx->h, ampheck_sha256_iv, sizeof(ctx->h));
 	
 	ctx->length = 0;
+	ctx->fill = 0;
 }
 
-void ampheck_sha256_transform(struct ampheck_sha256 *ctx, const uint8_t *data, size_t blocks)
+void ampheck_sha256_transform_generic(struct ampheck_sha256 *ctx, const uint8_t *data, size_t blocks)
 {
 	for (size_t i = 0; i < blocks; ++i)
 	{
@@ -164,63 +166,189 @@ void ampheck_sha256_transform(struct ampheck_sha256 *ctx, const uint8_t *data, s
 	}
 }
 
-void ampheck_sha256_update(struct ampheck_sha256 *ctx, const uint8_t *data, size_t size)
+const struct ampheck_backend ampheck_sha256_backends[] =
+{
+#ifdef AMPHECK_X86
+	{ "shani", AMPHECK_CPU_SHA | AMPHECK_CPU_SSE41, (ampheck_backend_fn) ampheck_sha256_transform_shani },
+	{ "avx2", AMPHECK_CPU_AVX2 | AMPHECK_CPU_BMI2, (ampheck_backend_fn) ampheck_sha256_transform_avx2 },
+#endif
+	{ "generic", 0, (ampheck_backend_fn) ampheck_sha256_transform_generic },
+	{ NULL, 0, NULL }
+};
+
+void ampheck_sha256_transform(struct ampheck_sha256 *ctx, const uint8_t *data, size_t blocks)
+{
+	static void (*transform)(struct ampheck_sha256 *, const uint8_t *, size_t) = NULL;
+	void (*selected)(struct ampheck_sha256 *, const uint8_t *, size_t) = AMPHECK_LOAD(transform);
+	
+	if (selected == NULL)
+	{
+		selected = (void (*)(struct ampheck_sha256 *, const uint8_t *, size_t)) ampheck_backend_select("sha256", ampheck_sha256_backends)->transform;
+		AMPHECK_STORE(transform, selected);
+	}
+	
+	selected(ctx, data, blocks);
+}
+
+const struct ampheck_lanes ampheck_sha256_lanes[] =
+{
+#ifdef AMPHECK_X86
+	{ "avx512", AMPHECK_CPU_AVX512F, 16, ampheck_sha256_lanes_avx512 },
+	{ "shani", AMPHECK_CPU_SHA | AMPHECK_CPU_SSE41, 1, NULL },
+	{ "avx2", AMPHECK_CPU_AVX2, 8, ampheck_sha256_lanes_avx2 },
+#endif
+	{ "generic", 0, 1, NULL },
+	{ NULL, 0, 0, NULL }
+};
+
+static void sha256_batch_transform(void *h, const uint8_t *data, size_t blocks)
 {
-	size_t tmp = size;
+	struct ampheck_sha256 ctx;
 	
-	if (size >= 64 - ctx->length % 64)
+	memcpy(ctx.h, h, sizeof(ctx.h));
+	ampheck_sha256_transform(&ctx, data, blocks);
+	memcpy(h, ctx.h, sizeof(ctx.h));
+}
+
+static void sha256_batch_init(void *ctx)
+{
+	ampheck_sha256_init(ctx);
+}
+
+static struct ampheck_batch sha256_batch =
+{
+	"sha256", ampheck_sha256_lanes, NULL, sha256_batch_transform, sha256_batch_init,
+	sizeof(struct ampheck_sha256), offsetof(struct ampheck_sha256, buffer),
+	offsetof(struct ampheck_sha256, length), offsetof(struct ampheck_sha256, fill),
+	8, 4, 64, 32, 1
+};
+
+/* Out of line, so that the appends in ampheck_sha256_update() need no stack frame. */
+static void __attribute__((noinline)) sha256_update_blocks(struct ampheck_sha256 *ctx, const uint8_t *data, size_t size)
+{
+	if (ctx->fill > 0)
 	{
-		memcpy(&ctx->buffer[ctx->length % 64], data, 64 - ctx->length % 64);
+		memcpy(&ctx->buffer[ctx->fill], data, 64 - ctx->fill);
 		
-		data += 64 - ctx->length % 64;
-		size -= 64 - ctx->length % 64;
+		data += 64 - ctx->fill;
+		size -= 64 - ctx->fill;
 		
 		ampheck_sha256_transform(ctx, ctx->buffer, 1);
-		ampheck_sha256_transform(ctx, data, size / 64);
-		
-		data += size & ~63;
-		size %= 64;
+	}
+	
+	ampheck_sha256_transform(ctx, data, size / 64);
+	
+	data += size & ~(size_t) 63;
+	ctx->fill = (uint32_t) (size % 64);
+	
+	memcpy(ctx->buffer, data, ctx->fill);
+}
+
+void ampheck_sha256_update(struct ampheck_sha256 *ctx, const uint8_t *data, size_t size)
+{
+	ctx->length += size;
+	
+	if (size < 64 - ctx->fill)
+	{
+		uint8_t *p = &ctx->buffer[ctx->fill];
 		
-		memcpy(ctx->buffer, data, size);
+		ctx->fill += (uint32_t) size;
+		memcpy(p, data, size);
 	}
 	else
 	{
-		memcpy(&ctx->buffer[ctx->length % 64], data, size);
+		sha256_update_blocks(ctx, data, size);
+	}
+}
+
+void ampheck_sha256_updatev(struct ampheck_sha256 *ctx, const struct iovec *iov, int iovcnt)
+{
+	for (int i = 0; i < iovcnt; ++i)
+	{
+		ampheck_sha256_update(ctx, iov[i].iov_base, iov[i].iov_len);
 	}
-	
-	ctx->length += tmp;
 }
 
 void ampheck_sha256_finish(const struct ampheck_sha256 *ctx, uint8_t *digest)
 {
 	struct ampheck_sha256 tmp;
 	
-	memcpy(tmp.h, ctx->h, 8 * sizeof(uint32_t));
-	memcpy(tmp.buffer, ctx->buffer, ctx->length % 64);
+	memcpy(tmp.h, ctx->h, sizeof(tmp.h));
+	memcpy(tmp.buffer, ctx->buffer, ctx->fill);
+	tmp.length = ctx->length;
+	tmp.fill = ctx->fill;
 	
-	tmp.buffer[ctx->length % 64] = 0x80;
+	ampheck_sha256_finish_inplace(&tmp, digest);
+}
+
+void ampheck_sha256_finish_inplace(struct ampheck_sha256 *ctx, uint8_t *digest)
+{
+	ctx->buffer[ctx->fill] = 0x80;
 	
-	if (ctx->length % 64 < 56)
+	if (ctx->fill < 56)
 	{
-		memset(&tmp.buffer[ctx->length % 64 + 1], 0x00, 55 - ctx->length % 64);
+		memset(&ctx->buffer[ctx->fill + 1], 0x00, 55 - ctx->fill);
 	}
 	else
 	{
-		memset(&tmp.buffer[ctx->length % 64 + 1], 0x00, 63 - ctx->length % 64);
-		ampheck_sha256_transform(&tmp, tmp.buffer, 1);
+		memset(&ctx->buffer[ctx->fill + 1], 0x00, 63 - ctx->fill);
+		ampheck_sha256_transform(ctx, ctx->buffer, 1);
 		
-		memset(tmp.buffer, 0x00, 56);
+		memset(ctx->buffer, 0x00, 56);
+	}
+	
+	UNPACK_64_BE(ctx->length * 8, &ctx->buffer[56]);
+	ampheck_sha256_transform(ctx, ctx->buffer, 1);
+	
+	UNPACK_32_BE(ctx->h[0], &digest[ 0]);
+	UNPACK_32_BE(ctx->h[1], &digest[ 4]);
+	UNPACK_32_BE(ctx->h[2], &digest[ 8]);
+	UNPACK_32_BE(ctx->h[3], &digest[12]);
+	UNPACK_32_BE(ctx->h[4], &digest[16]);
+	UNPACK_32_BE(ctx->h[5], &digest[20]);
+	UNPACK_32_BE(ctx->h[6], &digest[24]);
+	UNPACK_32_BE(ctx->h[7], &digest[28]);
+}
+
+void ampheck_sha256_digest(const uint8_t *data, size_t length, uint8_t *digest)
+{
+	struct ampheck_sha256 ctx;
+	uint8_t final[128];
+	
+	ampheck_sha256_init(&ctx);
+	
+	if (length >= 64)
+	{
+		ampheck_sha256_transform(&ctx, data, length / 64);
 	}
 	
-	UNPACK_64_BE(ctx->length * 8, &tmp.buffer[56]);
-	ampheck_sha256_transform(&tmp, tmp.buffer, 1);
-	
-	UNPACK_32_BE(tmp.h[0], &digest[ 0]);
-	UNPACK_32_BE(tmp.h[1], &digest[ 4]);
-	UNPACK_32_BE(tmp.h[2], &digest[ 8]);
-	UNPACK_32_BE(tmp.h[3], &digest[12]);
-	UNPACK_32_BE(tmp.h[4], &digest[16]);
-	UNPACK_32_BE(tmp.h[5], &digest[20]);
-	UNPACK_32_BE(tmp.h[6], &digest[24]);
-	UNPACK_32_BE(tmp.h[7], &digest[28]);
+	ampheck_sha256_transform(&ctx, final, ampheck_final(final, &data[length & ~(size_t) 63], length, 64, 1));
+	
+	for (int j = 0; j < 8; ++j)
+	{
+		UNPACK_32_BE(ctx.h[j], &digest[j * 4]);
+	}
+}
+
+void ampheck_sha256_init_batch(struct ampheck_sha256 *ctx, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		ampheck_sha256_init(&ctx[i]);
+	}
+}
+
+void ampheck_sha256_update_batch(struct ampheck_sha256 *ctx, const uint8_t *const data[], const size_t length[], size_t count)
+{
+	ampheck_batch_update(&sha256_batch, ctx, data, length, count);
+}
+
+void ampheck_sha256_finish_batch(const struct ampheck_sha256 *ctx, uint8_t *const digest[], size_t count)
+{
+	ampheck_batch_finish(&sha256_batch, ctx, digest, count);
+}
+
+void ampheck_sha256_mgr_init(struct ampheck_mgr *mgr)
+{
+	ampheck_mgr_init(mgr, &sha256_batch);
 }
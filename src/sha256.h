@@ -21,16 +21,61 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "align.h"
+#include "mgr.h"
+
+struct iovec;
+
+/*
+	The chaining values, length and fill level come first and the block
+	buffer starts on a cache line of its own, aligned for the SIMD kernels.
+	Contexts on the heap need 64-byte aligned memory, e.g. from
+	posix_memalign().
+*/
 struct ampheck_sha256
 {
 	uint32_t h[8];
-	uint8_t buffer[64];
-	
 	uint64_t length;
+	uint32_t fill;
+	
+	AMPHECK_ALIGNED(64) uint8_t buffer[64];
 };
 
 void ampheck_sha256_init(struct ampheck_sha256 *ctx);
 void ampheck_sha256_update(struct ampheck_sha256 *ctx, const uint8_t *data, size_t length);
+
+/*
+	Continues the message with the `iovcnt' fragments of `iov' in order.
+	Whole blocks are compressed straight from each fragment; only the bytes
+	of a block that straddles two fragments go through the context buffer.
+*/
+void ampheck_sha256_updatev(struct ampheck_sha256 *ctx, const struct iovec *iov, int iovcnt);
+
 void ampheck_sha256_finish(const struct ampheck_sha256 *ctx, uint8_t *digest);
 
+/*
+	Like ampheck_sha256_finish(), but pads in `ctx' itself instead of a copy,
+	so `ctx' must be initialised again before it is reused.
+*/
+void ampheck_sha256_finish_inplace(struct ampheck_sha256 *ctx, uint8_t *digest);
+
+/*
+	Hashes `length' bytes of `data' in one go, without a context buffer:
+	whole blocks are compressed in place and only the padded tail is built
+	on the stack.
+*/
+void ampheck_sha256_digest(const uint8_t *data, size_t length, uint8_t *digest);
+
+/*
+	Batch versions over arrays of `count' independent contexts; message i
+	continues with `length[i]' bytes of `data[i]'.  The messages are hashed
+	side by side in SIMD lanes where the CPU allows it.
+*/
+void ampheck_sha256_init_batch(struct ampheck_sha256 *ctx, size_t count);
+void ampheck_sha256_update_batch(struct ampheck_sha256 *ctx, const uint8_t *const data[], const size_t length[], size_t count);
+void ampheck_sha256_finish_batch(const struct ampheck_sha256 *ctx, uint8_t *const digest[], size_t count);
+
+/* Sets up `mgr' to run SHA-256 jobs; see mgr.h. */
+void ampheck_sha256_mgr_init(struct ampheck_mgr *mgr);
+
 #endif
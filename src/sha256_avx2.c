@@ -0,0 +1,172 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ampheck.h"
+#include "backends.h"
+#include "sha256.h"
+
+#ifdef AMPHECK_X86
+
+#include <immintrin.h>
+
+/*
+	The message schedule of two blocks is expanded at once, one block in each
+	128-bit half, and stored with the round constants already added.  The
+	rounds stay scalar; with BMI2 every ROR becomes a flag-free RORX.
+*/
+
+#define CH(x, y, z) (z ^ (x & (y ^ z)))
+#define MAJ(x, y, z) ((x & y) | (z & (x | y)))
+
+#define SHA256_T0(x) (ROR(x,  2) ^ ROR(x, 13) ^ ROR(x, 22))
+#define SHA256_T1(x) (ROR(x,  6) ^ ROR(x, 11) ^ ROR(x, 25))
+
+#define SHA256_PRC(a, b, c, d, e, f, g, h, wk) { \
+	uint32_t t1 = wv[h] + SHA256_T1(wv[e]) + CH(wv[e], wv[f], wv[g]) + wk; \
+	wv[d] += t1; \
+	wv[h]  = t1 + SHA256_T0(wv[a]) + MAJ(wv[a], wv[b], wv[c]); \
+}
+
+#define SHA256_AVX2_ROR(x, y) _mm256_or_si256(_mm256_srli_epi32(x, y), _mm256_slli_epi32(x, 32 - (y)))
+
+#define SHA256_AVX2_S0(x) _mm256_xor_si256(_mm256_xor_si256(SHA256_AVX2_ROR(x,  7), SHA256_AVX2_ROR(x, 18)), _mm256_srli_epi32(x,  3))
+#define SHA256_AVX2_S1(x) _mm256_xor_si256(_mm256_xor_si256(SHA256_AVX2_ROR(x, 17), SHA256_AVX2_ROR(x, 19)), _mm256_srli_epi32(x, 10))
+
+#define SHA256_AVX2_LOAD(x, g) { \
+	x = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *) &lo[(g) << 4])), \
+	                            _mm_loadu_si128((const __m128i *) &hi[(g) << 4]), 1); \
+	x = _mm256_shuffle_epi8(x, mask); \
+	_mm256_store_si256((__m256i *) &wk[(g) << 3], _mm256_add_epi32(x, _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) &sha256_k[(g) << 2])))); \
+}
+
+#define SHA256_AVX2_EXT(x0, x1, x2, x3, g) { \
+	x0 = sha256_avx2_ext(x0, x1, x2, x3); \
+	_mm256_store_si256((__m256i *) &wk[(g) << 3], _mm256_add_epi32(x0, _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) &sha256_k[(g) << 2])))); \
+}
+
+static const uint32_t sha256_k[64] =
+{
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/* Computes W[t..t+3] from W[t-16..t-1]; the last two words need the first two. */
+__attribute__((target("avx2"), always_inline))
+static inline __m256i sha256_avx2_ext(__m256i x0, __m256i x1, __m256i x2, __m256i x3)
+{
+	__m256i t, l, h;
+	
+	t = _mm256_add_epi32(x0, _mm256_alignr_epi8(x3, x2, 4));
+	t = _mm256_add_epi32(t, SHA256_AVX2_S0(_mm256_alignr_epi8(x1, x0, 4)));
+	
+	l = _mm256_shuffle_epi32(x3, 0xFE);
+	l = _mm256_add_epi32(t, SHA256_AVX2_S1(l));
+	
+	h = _mm256_shuffle_epi32(l, 0x40);
+	h = _mm256_add_epi32(t, SHA256_AVX2_S1(h));
+	
+	return _mm256_blend_epi32(l, h, 0xCC);
+}
+
+__attribute__((target("avx2,bmi2"), always_inline))
+static inline void sha256_avx2_rounds(uint32_t *h, const uint32_t *wk)
+{
+	uint32_t wv[8];
+	
+	wv[0] = h[0];
+	wv[1] = h[1];
+	wv[2] = h[2];
+	wv[3] = h[3];
+	wv[4] = h[4];
+	wv[5] = h[5];
+	wv[6] = h[6];
+	wv[7] = h[7];
+	
+	for (size_t t = 0; t < 64; t += 8)
+	{
+		SHA256_PRC(0, 1, 2, 3, 4, 5, 6, 7, wk[(t << 1)     ]);
+		SHA256_PRC(7, 0, 1, 2, 3, 4, 5, 6, wk[(t << 1) +  1]);
+		SHA256_PRC(6, 7, 0, 1, 2, 3, 4, 5, wk[(t << 1) +  2]);
+		SHA256_PRC(5, 6, 7, 0, 1, 2, 3, 4, wk[(t << 1) +  3]);
+		SHA256_PRC(4, 5, 6, 7, 0, 1, 2, 3, wk[(t << 1) +  8]);
+		SHA256_PRC(3, 4, 5, 6, 7, 0, 1, 2, wk[(t << 1) +  9]);
+		SHA256_PRC(2, 3, 4, 5, 6, 7, 0, 1, wk[(t << 1) + 10]);
+		SHA256_PRC(1, 2, 3, 4, 5, 6, 7, 0, wk[(t << 1) + 11]);
+	}
+	
+	h[0] += wv[0];
+	h[1] += wv[1];
+	h[2] += wv[2];
+	h[3] += wv[3];
+	h[4] += wv[4];
+	h[5] += wv[5];
+	h[6] += wv[6];
+	h[7] += wv[7];
+}
+
+__attribute__((target("avx2,bmi2")))
+void ampheck_sha256_transform_avx2(struct ampheck_sha256 *ctx, const uint8_t *data, size_t blocks)
+{
+	const __m256i mask = _mm256_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL,
+	                                       0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+	
+	/* Four words of the first block, then four of the second, and so on. */
+	uint32_t wk[128] __attribute__((aligned(32)));
+	
+	for (size_t i = 0; i < blocks; i += 2)
+	{
+		const uint8_t *lo = &data[i << 6];
+		const uint8_t *hi = i + 1 < blocks ? lo + 64 : lo;
+		__m256i x0, x1, x2, x3;
+		
+		SHA256_AVX2_LOAD(x0, 0);
+		SHA256_AVX2_LOAD(x1, 1);
+		SHA256_AVX2_LOAD(x2, 2);
+		SHA256_AVX2_LOAD(x3, 3);
+		
+		SHA256_AVX2_EXT(x0, x1, x2, x3,  4);
+		SHA256_AVX2_EXT(x1, x2, x3, x0,  5);
+		SHA256_AVX2_EXT(x2, x3, x0, x1,  6);
+		SHA256_AVX2_EXT(x3, x0, x1, x2,  7);
+		SHA256_AVX2_EXT(x0, x1, x2, x3,  8);
+		SHA256_AVX2_EXT(x1, x2, x3, x0,  9);
+		SHA256_AVX2_EXT(x2, x3, x0, x1, 10);
+		SHA256_AVX2_EXT(x3, x0, x1, x2, 11);
+		SHA256_AVX2_EXT(x0, x1, x2, x3, 12);
+		SHA256_AVX2_EXT(x1, x2, x3, x0, 13);
+		SHA256_AVX2_EXT(x2, x3, x0, x1, 14);
+		SHA256_AVX2_EXT(x3, x0, x1, x2, 15);
+		
+		sha256_avx2_rounds(ctx->h, wk);
+		
+		if (i + 1 < blocks)
+		{
+			sha256_avx2_rounds(ctx->h, &wk[4]);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,204 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "backends.h"
+#include "lanes.h"
+#include "sha256.h"
+
+#ifdef AMPHECK_X86
+
+#include <immintrin.h>
+
+/*
+	Eight (AVX2) or sixteen (AVX-512) messages are hashed side by side, one
+	per 32-bit lane.  A block is loaded as one row per message and transposed
+	so that each vector holds the same message word of every lane; from then
+	on the rounds are the scalar ones written with vector operations.
+*/
+
+#define SHA256_LANES_PRC(a, b, c, d, e, f, g, h, t) { \
+	V t1 = ADD(ADD(ADD(wv[h], T1(wv[e])), CH(wv[e], wv[f], wv[g])), ADD(w[(t) & 0x0F], SET1(sha256_k[t]))); \
+	wv[d] = ADD(wv[d], t1); \
+	wv[h] = ADD(t1, ADD(T0(wv[a]), MAJ(wv[a], wv[b], wv[c]))); \
+}
+
+#define SHA256_LANES_EXT(t) ( \
+	w[(t) & 0x0F] = ADD(ADD(w[(t) & 0x0F], S0(w[((t) + 1) & 0x0F])), ADD(S1(w[((t) - 2) & 0x0F]), w[((t) - 7) & 0x0F])) \
+)
+
+#define SHA256_LANES_RND(t) { \
+	if ((t) >= 16) \
+	{ \
+		SHA256_LANES_EXT((t)    ); SHA256_LANES_EXT((t) + 1); SHA256_LANES_EXT((t) + 2); SHA256_LANES_EXT((t) + 3); \
+		SHA256_LANES_EXT((t) + 4); SHA256_LANES_EXT((t) + 5); SHA256_LANES_EXT((t) + 6); SHA256_LANES_EXT((t) + 7); \
+	} \
+	\
+	SHA256_LANES_PRC(0, 1, 2, 3, 4, 5, 6, 7, (t)    ); \
+	SHA256_LANES_PRC(7, 0, 1, 2, 3, 4, 5, 6, (t) + 1); \
+	SHA256_LANES_PRC(6, 7, 0, 1, 2, 3, 4, 5, (t) + 2); \
+	SHA256_LANES_PRC(5, 6, 7, 0, 1, 2, 3, 4, (t) + 3); \
+	SHA256_LANES_PRC(4, 5, 6, 7, 0, 1, 2, 3, (t) + 4); \
+	SHA256_LANES_PRC(3, 4, 5, 6, 7, 0, 1, 2, (t) + 5); \
+	SHA256_LANES_PRC(2, 3, 4, 5, 6, 7, 0, 1, (t) + 6); \
+	SHA256_LANES_PRC(1, 2, 3, 4, 5, 6, 7, 0, (t) + 7); \
+}
+
+#define SHA256_LANES_BLOCK() { \
+	for (int j = 0; j < 8; ++j) \
+	{ \
+		wv[j] = s[j]; \
+	} \
+	\
+	SHA256_LANES_RND( 0); SHA256_LANES_RND( 8); SHA256_LANES_RND(16); SHA256_LANES_RND(24); \
+	SHA256_LANES_RND(32); SHA256_LANES_RND(40); SHA256_LANES_RND(48); SHA256_LANES_RND(56); \
+	\
+	for (int j = 0; j < 8; ++j) \
+	{ \
+		s[j] = ADD(s[j], wv[j]); \
+	} \
+}
+
+static const uint32_t sha256_k[64] =
+{
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define V __m256i
+#define ADD(x, y) _mm256_add_epi32(x, y)
+#define SET1(x) _mm256_set1_epi32((int) (x))
+#define VROR(x, y) _mm256_or_si256(_mm256_srli_epi32(x, y), _mm256_slli_epi32(x, 32 - (y)))
+#define XOR3(x, y, z) _mm256_xor_si256(_mm256_xor_si256(x, y), z)
+#define CH(x, y, z) _mm256_xor_si256(z, _mm256_and_si256(x, _mm256_xor_si256(y, z)))
+#define MAJ(x, y, z) _mm256_or_si256(_mm256_and_si256(x, y), _mm256_and_si256(z, _mm256_or_si256(x, y)))
+#define S0(x) XOR3(VROR(x,  7), VROR(x, 18), _mm256_srli_epi32(x,  3))
+#define S1(x) XOR3(VROR(x, 17), VROR(x, 19), _mm256_srli_epi32(x, 10))
+#define T0(x) XOR3(VROR(x,  2), VROR(x, 13), VROR(x, 22))
+#define T1(x) XOR3(VROR(x,  6), VROR(x, 11), VROR(x, 25))
+
+__attribute__((target("avx2")))
+void ampheck_sha256_lanes_avx2(void *state, const uint8_t *const data[], size_t blocks)
+{
+	const __m256i mask = _mm256_set_epi8(12, 13, 14, 15,  8,  9, 10, 11,  4,  5,  6,  7,  0,  1,  2,  3,
+	                                     12, 13, 14, 15,  8,  9, 10, 11,  4,  5,  6,  7,  0,  1,  2,  3);
+	__m256i *h = state;
+	__m256i s[8];
+	
+	for (int j = 0; j < 8; ++j)
+	{
+		s[j] = _mm256_loadu_si256(&h[j]);
+	}
+	
+	for (size_t i = 0; i < blocks; ++i)
+	{
+		__m256i wv[8];
+		__m256i w[16];
+		
+		for (int j = 0; j < 8; ++j)
+		{
+			w[j    ] = _mm256_loadu_si256((const __m256i *) &data[j][(i << 6)     ]);
+			w[j + 8] = _mm256_loadu_si256((const __m256i *) &data[j][(i << 6) + 32]);
+		}
+		
+		ampheck_transpose8(&w[0]);
+		ampheck_transpose8(&w[8]);
+		
+		for (int j = 0; j < 16; ++j)
+		{
+			w[j] = _mm256_shuffle_epi8(w[j], mask);
+		}
+		
+		SHA256_LANES_BLOCK();
+	}
+	
+	for (int j = 0; j < 8; ++j)
+	{
+		_mm256_storeu_si256(&h[j], s[j]);
+	}
+}
+
+#undef V
+#undef ADD
+#undef SET1
+#undef VROR
+#undef XOR3
+#undef CH
+#undef MAJ
+#undef S0
+#undef S1
+#undef T0
+#undef T1
+
+#define V __m512i
+#define ADD(x, y) _mm512_add_epi32(x, y)
+#define SET1(x) _mm512_set1_epi32((int) (x))
+#define VROR(x, y) _mm512_ror_epi32(x, y)
+#define XOR3(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0x96)
+#define CH(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0xCA)
+#define MAJ(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0xE8)
+#define S0(x) XOR3(VROR(x,  7), VROR(x, 18), _mm512_srli_epi32(x,  3))
+#define S1(x) XOR3(VROR(x, 17), VROR(x, 19), _mm512_srli_epi32(x, 10))
+#define T0(x) XOR3(VROR(x,  2), VROR(x, 13), VROR(x, 22))
+#define T1(x) XOR3(VROR(x,  6), VROR(x, 11), VROR(x, 25))
+
+__attribute__((target("avx512f")))
+void ampheck_sha256_lanes_avx512(void *state, const uint8_t *const data[], size_t blocks)
+{
+	__m512i *h = state;
+	__m512i s[8];
+	
+	for (int j = 0; j < 8; ++j)
+	{
+		s[j] = _mm512_loadu_si512(&h[j]);
+	}
+	
+	for (size_t i = 0; i < blocks; ++i)
+	{
+		__m512i wv[8];
+		__m512i w[16];
+		
+		for (int j = 0; j < 16; ++j)
+		{
+			w[j] = _mm512_loadu_si512(&data[j][i << 6]);
+		}
+		
+		ampheck_transpose16(w);
+		
+		for (int j = 0; j < 16; ++j)
+		{
+			w[j] = ampheck_bswap32_avx512(w[j]);
+		}
+		
+		SHA256_LANES_BLOCK();
+	}
+	
+	for (int j = 0; j < 8; ++j)
+	{
+		_mm512_storeu_si512(&h[j], s[j]);
+	}
+}
+
+#endif
@@ -0,0 +1,116 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "backends.h"
+#include "sha256.h"
+
+#ifdef AMPHECK_X86
+
+#include <immintrin.h>
+
+/*
+	Each message vector holds four schedule words.  A step runs four rounds
+	on `cur', finishes the schedule of `next' and starts the one of `prev'.
+*/
+
+#define SHA256_NI_RND(cur, k) { \
+	msg = _mm_add_epi32(cur, _mm_loadu_si128((const __m128i *) &sha256_k[k])); \
+	state1 = _mm_sha256rnds2_epu32(state1, state0, msg); \
+	msg = _mm_shuffle_epi32(msg, 0x0E); \
+	state0 = _mm_sha256rnds2_epu32(state0, state1, msg); \
+}
+
+#define SHA256_NI_MSG2(cur, prev, next) { \
+	next = _mm_add_epi32(next, _mm_alignr_epi8(cur, prev, 4)); \
+	next = _mm_sha256msg2_epu32(next, cur); \
+}
+
+#define SHA256_NI_MSG1(cur, prev) { \
+	prev = _mm_sha256msg1_epu32(prev, cur); \
+}
+
+static const uint32_t sha256_k[64] =
+{
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+__attribute__((target("sha,sse4.1")))
+void ampheck_sha256_transform_shani(struct ampheck_sha256 *ctx, const uint8_t *data, size_t blocks)
+{
+	const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+	__m128i state0, state1, msg, tmp;
+	__m128i m0, m1, m2, m3;
+	
+	/* The round instructions want the state as ABEF and CDGH. */
+	tmp    = _mm_loadu_si128((const __m128i *) &ctx->h[0]);
+	state1 = _mm_loadu_si128((const __m128i *) &ctx->h[4]);
+	tmp    = _mm_shuffle_epi32(tmp, 0xB1);
+	state1 = _mm_shuffle_epi32(state1, 0x1B);
+	state0 = _mm_alignr_epi8(tmp, state1, 8);
+	state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+	
+	for (size_t i = 0; i < blocks; ++i)
+	{
+		const __m128i abef = state0;
+		const __m128i cdgh = state1;
+		
+		m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) &data[(i << 6)     ]), mask);
+		m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) &data[(i << 6) + 16]), mask);
+		m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) &data[(i << 6) + 32]), mask);
+		m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) &data[(i << 6) + 48]), mask);
+		
+		SHA256_NI_RND(m0,  0);
+		SHA256_NI_RND(m1,  4); SHA256_NI_MSG1(m1, m0);
+		SHA256_NI_RND(m2,  8); SHA256_NI_MSG1(m2, m1);
+		SHA256_NI_RND(m3, 12); SHA256_NI_MSG2(m3, m2, m0); SHA256_NI_MSG1(m3, m2);
+		SHA256_NI_RND(m0, 16); SHA256_NI_MSG2(m0, m3, m1); SHA256_NI_MSG1(m0, m3);
+		SHA256_NI_RND(m1, 20); SHA256_NI_MSG2(m1, m0, m2); SHA256_NI_MSG1(m1, m0);
+		SHA256_NI_RND(m2, 24); SHA256_NI_MSG2(m2, m1, m3); SHA256_NI_MSG1(m2, m1);
+		SHA256_NI_RND(m3, 28); SHA256_NI_MSG2(m3, m2, m0); SHA256_NI_MSG1(m3, m2);
+		SHA256_NI_RND(m0, 32); SHA256_NI_MSG2(m0, m3, m1); SHA256_NI_MSG1(m0, m3);
+		SHA256_NI_RND(m1, 36); SHA256_NI_MSG2(m1, m0, m2); SHA256_NI_MSG1(m1, m0);
+		SHA256_NI_RND(m2, 40); SHA256_NI_MSG2(m2, m1, m3); SHA256_NI_MSG1(m2, m1);
+		SHA256_NI_RND(m3, 44); SHA256_NI_MSG2(m3, m2, m0); SHA256_NI_MSG1(m3, m2);
+		SHA256_NI_RND(m0, 48); SHA256_NI_MSG2(m0, m3, m1); SHA256_NI_MSG1(m0, m3);
+		SHA256_NI_RND(m1, 52); SHA256_NI_MSG2(m1, m0, m2);
+		SHA256_NI_RND(m2, 56); SHA256_NI_MSG2(m2, m1, m3);
+		SHA256_NI_RND(m3, 60);
+		
+		state0 = _mm_add_epi32(state0, abef);
+		state1 = _mm_add_epi32(state1, cdgh);
+	}
+	
+	tmp    = _mm_shuffle_epi32(state0, 0x1B);
+	state1 = _mm_shuffle_epi32(state1, 0xB1);
+	state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+	state1 = _mm_alignr_epi8(state1, tmp, 8);
+	
+	_mm_storeu_si128((__m128i *) &ctx->h[0], state0);
+	_mm_storeu_si128((__m128i *) &ctx->h[4], state1);
+}
+
+#endif
@@ -0,0 +1,221 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "ampheck.h"
+#include "backends.h"
+#include "sha256.h"
+#include "sha256d.h"
+
+/*
+	The second hash always compresses one block: the 32-byte digest of the
+	first, then the padding of a 256-bit message.  Only the digest half of
+	that block changes from call to call.
+*/
+static const uint8_t sha256d_pad[32] =
+{
+	0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00
+};
+
+/* The first hash of a message on its own, through the single-stream transform. */
+void ampheck_sha256_single(const uint8_t *data, size_t length, uint8_t *digest)
+{
+	struct ampheck_sha256 ctx;
+	uint8_t final[128];
+	
+	memcpy(ctx.h, ampheck_sha256_iv, sizeof(ctx.h));
+	ampheck_sha256_transform(&ctx, data, length / 64);
+	ampheck_sha256_transform(&ctx, final, ampheck_final(final, &data[length & ~(size_t) 63], length, 64, 1));
+	
+	for (int j = 0; j < 8; ++j)
+	{
+		UNPACK_32_BE(ctx.h[j], &digest[j * 4]);
+	}
+}
+
+/* The second hash of one block, through the single-stream transform. */
+static void sha256d_block(const uint8_t *second, uint8_t *digest)
+{
+	struct ampheck_sha256 ctx;
+	
+	memcpy(ctx.h, ampheck_sha256_iv, sizeof(ctx.h));
+	ampheck_sha256_transform(&ctx, second, 1);
+	
+	for (int j = 0; j < 8; ++j)
+	{
+		UNPACK_32_BE(ctx.h[j], &digest[j * 4]);
+	}
+}
+
+void ampheck_sha256d(const uint8_t *data, size_t length, uint8_t *digest)
+{
+	uint8_t second[64];
+	
+	ampheck_sha256_single(data, length, second);
+	memcpy(&second[32], sha256d_pad, sizeof(sha256d_pad));
+	
+	sha256d_block(second, digest);
+}
+
+static const struct ampheck_lanes *sha256d_kernel(void)
+{
+	static const struct ampheck_lanes *kernel = NULL;
+	const struct ampheck_lanes *selected = AMPHECK_LOAD(kernel);
+	
+	if (selected == NULL)
+	{
+		selected = ampheck_lanes_select("sha256", ampheck_sha256_lanes);
+		AMPHECK_STORE(kernel, selected);
+	}
+	
+	return selected;
+}
+
+/*
+	Groups of messages go through the SHA-256 kernel together.  All of them
+	have the same length, so they all take the same number of blocks; a
+	short group fills its spare lanes with its first message.  With most
+	lanes idle, as in the tail of a batch, one stream at a time is faster.
+*/
+void ampheck_sha256_fixed(const uint8_t *const data[], size_t length, uint8_t *const digest[], size_t count)
+{
+	const struct ampheck_lanes *kernel = sha256d_kernel();
+	const unsigned int lanes = kernel->lanes;
+	uint8_t final[AMPHECK_MGR_LANES][128];
+	uint32_t state[8 * AMPHECK_MGR_LANES];
+	const uint8_t *rows[AMPHECK_MGR_LANES];
+	size_t blocks = 0;
+	
+	for (size_t i = 0; i < count; i += lanes)
+	{
+		const size_t group = count - i < lanes ? count - i : lanes;
+		
+		if (kernel->transform == NULL || group <= lanes / 4)
+		{
+			for (size_t l = 0; l < group; ++l)
+			{
+				ampheck_sha256_single(data[i + l], length, digest[i + l]);
+			}
+			
+			continue;
+		}
+		
+		for (unsigned int l = 0; l < lanes; ++l)
+		{
+			rows[l] = data[i + (l < group ? l : 0)];
+		}
+		
+		for (unsigned int j = 0; j < 8; ++j)
+		{
+			for (unsigned int l = 0; l < lanes; ++l)
+			{
+				state[j * lanes + l] = ampheck_sha256_iv[j];
+			}
+		}
+		
+		if (length >= 64)
+		{
+			kernel->transform(state, rows, length / 64);
+		}
+		
+		for (unsigned int l = 0; l < lanes; ++l)
+		{
+			blocks = ampheck_final(final[l], &rows[l][length & ~(size_t) 63], length, 64, 1);
+			rows[l] = final[l];
+		}
+		
+		kernel->transform(state, rows, blocks);
+		
+		for (size_t l = 0; l < group; ++l)
+		{
+			for (unsigned int j = 0; j < 8; ++j)
+			{
+				UNPACK_32_BE(state[j * lanes + l], &digest[i + l][j * 4]);
+			}
+		}
+	}
+}
+
+/* Compresses the blocks of the second hash, `count' at most AMPHECK_MGR_LANES. */
+static void sha256d_second(uint8_t second[][64], size_t count, uint8_t *const digest[])
+{
+	const struct ampheck_lanes *kernel = sha256d_kernel();
+	const unsigned int lanes = kernel->lanes;
+	uint32_t state[8 * AMPHECK_MGR_LANES];
+	const uint8_t *rows[AMPHECK_MGR_LANES];
+	
+	for (size_t i = 0; i < count; i += lanes)
+	{
+		const size_t group = count - i < lanes ? count - i : lanes;
+		
+		if (kernel->transform == NULL || group <= lanes / 4)
+		{
+			for (size_t l = 0; l < group; ++l)
+			{
+				sha256d_block(second[i + l], digest[i + l]);
+			}
+			
+			continue;
+		}
+		
+		for (unsigned int l = 0; l < lanes; ++l)
+		{
+			rows[l] = second[i + (l < group ? l : 0)];
+			
+			for (unsigned int j = 0; j < 8; ++j)
+			{
+				state[j * lanes + l] = ampheck_sha256_iv[j];
+			}
+		}
+		
+		kernel->transform(state, rows, 1);
+		
+		for (size_t l = 0; l < group; ++l)
+		{
+			for (unsigned int j = 0; j < 8; ++j)
+			{
+				UNPACK_32_BE(state[j * lanes + l], &digest[i + l][j * 4]);
+			}
+		}
+	}
+}
+
+/* The first digests go straight into the blocks of the second hash, whose padding is set up once. */
+void ampheck_sha256d_batch(const uint8_t *const data[], size_t length, uint8_t *const digest[], size_t count)
+{
+	uint8_t second[AMPHECK_MGR_LANES][64];
+	uint8_t *first[AMPHECK_MGR_LANES];
+	
+	for (unsigned int l = 0; l < AMPHECK_MGR_LANES; ++l)
+	{
+		memcpy(&second[l][32], sha256d_pad, sizeof(sha256d_pad));
+		first[l] = second[l];
+	}
+	
+	for (size_t i = 0; i < count; i += AMPHECK_MGR_LANES)
+	{
+		const size_t group = count - i < AMPHECK_MGR_LANES ? count - i : AMPHECK_MGR_LANES;
+		
+		ampheck_sha256_fixed(&data[i], length, first, group);
+		sha256d_second(second, group, &digest[i]);
+	}
+}
@@ -0,0 +1,49 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ampheck_sha256d_h
+#define ampheck_sha256d_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+	Double SHA-256, SHA-256 of the SHA-256 digest, of `length' bytes of
+	`data', without a context.  The message is compressed straight from
+	`data' and the second hash uses a padding block fixed in advance, which
+	pays off most for short inputs such as 32, 64 and 80 bytes.
+
+	The batch version hashes `count' messages of the same `length' side by
+	side in SIMD lanes where the CPU allows it.
+*/
+void ampheck_sha256d(const uint8_t *data, size_t length, uint8_t *digest);
+void ampheck_sha256d_batch(const uint8_t *const data[], size_t length, uint8_t *const digest[], size_t count);
+
+/*
+	Scans the nonces `first' to `last' of the 80-byte block header `header',
+	whose nonce is the little-endian word in bytes 76 to 79.  A nonce
+	matches when the double SHA-256 digest of the header, read as a 256-bit
+	little-endian number, is not above `target', 32 bytes in the same order.
+	The matching nonces are written to `found' in increasing order until
+	there are `max' of them; returns how many were written.  The midstate of
+	the first 64 bytes is computed once per call and nonces are tried side by
+	side in SIMD lanes where the CPU allows it.
+*/
+size_t ampheck_sha256d_scan(const uint8_t *header, uint32_t first, uint32_t last, const uint8_t *target, uint32_t *found, size_t max);
+
+#endif
@@ -0,0 +1,345 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "ampheck.h"
+#include "backends.h"
+#include "sha256.h"
+#include "sha256d.h"
+
+#ifdef AMPHECK_X86
+#include <immintrin.h>
+#endif
+
+/*
+	Only the nonce, word 3 of the second block, changes between the headers
+	of a scan.  The midstate of the first block, the first three rounds of
+	the second and its schedule words 16 and 17 are worked out once; the
+	kernels run the rest for one nonce per lane.  The top word of the final
+	digest is set after round 60 of the second hash, so the kernels stop
+	there and hand it back; the few nonces it does not rule out are hashed
+	again in full and compared against the whole target.
+*/
+struct scan
+{
+	uint32_t midstate[8];
+	uint32_t state[8];
+	uint32_t w[16];
+};
+
+#define SCAN_PRC(t, x) { \
+	V t1 = ADD(ADD(ADD(wv[(7 - (t)) & 7], T1(wv[(4 - (t)) & 7])), CH(wv[(4 - (t)) & 7], wv[(5 - (t)) & 7], wv[(6 - (t)) & 7])), ADD(x, SET1(sha256_k[t]))); \
+	wv[(3 - (t)) & 7] = ADD(wv[(3 - (t)) & 7], t1); \
+	wv[(7 - (t)) & 7] = ADD(t1, ADD(T0(wv[(0 - (t)) & 7]), MAJ(wv[(0 - (t)) & 7], wv[(1 - (t)) & 7], wv[(2 - (t)) & 7]))); \
+}
+
+#define SCAN_EXT(t) ( \
+	w[(t) & 0x0F] = ADD(ADD(w[(t) & 0x0F], S0(w[((t) + 1) & 0x0F])), ADD(S1(w[((t) - 2) & 0x0F]), w[((t) - 7) & 0x0F])) \
+)
+
+/* Words below `n' are already in `w'. */
+#define SCAN_RND(t, n) SCAN_PRC(t, ((t) < (n) ? w[(t) & 0x0F] : SCAN_EXT(t)))
+
+#define SCAN_R4(t, n) { \
+	SCAN_RND((t)    , n); SCAN_RND((t) + 1, n); SCAN_RND((t) + 2, n); SCAN_RND((t) + 3, n); \
+}
+
+#define SCAN_R16(t, n) { \
+	SCAN_R4((t), n); SCAN_R4((t) + 4, n); SCAN_R4((t) + 8, n); SCAN_R4((t) + 12, n); \
+}
+
+/* Rounds 3 to 63 of the header's second block, then rounds 0 to 60 of the second hash; `w3' and `h7' hold one word per lane. */
+#define SCAN_BODY() { \
+	V wv[8]; \
+	V w[16]; \
+	\
+	for (int j = 0; j < 8; ++j) \
+	{ \
+		wv[j] = SET1(scan->state[j]); \
+	} \
+	\
+	for (int j = 0; j < 16; ++j) \
+	{ \
+		w[j] = SET1(scan->w[j]); \
+	} \
+	\
+	w[3] = LOAD(w3); \
+	\
+	SCAN_RND(3, 18); SCAN_R4(4, 18); SCAN_R4(8, 18); SCAN_R4(12, 18); \
+	SCAN_R16(16, 18); SCAN_R16(32, 18); SCAN_R16(48, 18); \
+	\
+	for (int j = 0; j < 8; ++j) \
+	{ \
+		w[j] = ADD(wv[j], SET1(scan->midstate[j])); \
+		wv[j] = SET1(ampheck_sha256_iv[j]); \
+	} \
+	\
+	w[8] = SET1(0x80000000); \
+	\
+	for (int j = 9; j < 15; ++j) \
+	{ \
+		w[j] = SET1(0); \
+	} \
+	\
+	w[15] = SET1(256); \
+	\
+	SCAN_R16(0, 16); SCAN_R16(16, 16); SCAN_R16(32, 16); \
+	SCAN_R4(48, 16); SCAN_R4(52, 16); SCAN_R4(56, 16); SCAN_RND(60, 16); \
+	\
+	STORE(h7, ADD(wv[7], SET1(ampheck_sha256_iv[7]))); \
+}
+
+static const uint32_t sha256_k[64] =
+{
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define V uint32_t
+#define ADD(x, y) ((uint32_t) ((x) + (y)))
+#define SET1(x) ((uint32_t) (x))
+#define LOAD(p) (*(p))
+#define STORE(p, x) (*(p) = (x))
+#define CH(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+#define MAJ(x, y, z) (((x) & (y)) | ((z) & ((x) | (y))))
+#define S0(x) (ROR(x,  7) ^ ROR(x, 18) ^ (x) >>  3)
+#define S1(x) (ROR(x, 17) ^ ROR(x, 19) ^ (x) >> 10)
+#define T0(x) (ROR(x,  2) ^ ROR(x, 13) ^ ROR(x, 22))
+#define T1(x) (ROR(x,  6) ^ ROR(x, 11) ^ ROR(x, 25))
+
+static void scan_prepare(struct scan *scan, const uint8_t *header)
+{
+	struct ampheck_sha256 ctx;
+	uint32_t *w = scan->w;
+	uint32_t *wv = scan->state;
+	
+	memcpy(ctx.h, ampheck_sha256_iv, sizeof(ctx.h));
+	ampheck_sha256_transform(&ctx, header, 1);
+	memcpy(scan->midstate, ctx.h, sizeof(ctx.h));
+	memcpy(scan->state, ctx.h, sizeof(ctx.h));
+	
+	PACK_32_BE(&header[64], &w[0]);
+	PACK_32_BE(&header[68], &w[1]);
+	PACK_32_BE(&header[72], &w[2]);
+	
+	w[3] = 0;
+	w[4] = 0x80000000;
+	memset(&w[5], 0x00, 10 * sizeof(uint32_t));
+	w[15] = 640;
+	
+	SCAN_PRC(0, w[0]);
+	SCAN_PRC(1, w[1]);
+	SCAN_PRC(2, w[2]);
+	
+	/* Words 16 and 17 take the places of words 0 and 1, which no later round reads. */
+	SCAN_EXT(16);
+	SCAN_EXT(17);
+}
+
+static void scan_generic(const struct scan *scan, const uint32_t *w3, uint32_t *h7)
+{
+	SCAN_BODY();
+}
+
+#undef V
+#undef ADD
+#undef SET1
+#undef LOAD
+#undef STORE
+#undef CH
+#undef MAJ
+#undef S0
+#undef S1
+#undef T0
+#undef T1
+
+#ifdef AMPHECK_X86
+
+#define V __m256i
+#define ADD(x, y) _mm256_add_epi32(x, y)
+#define SET1(x) _mm256_set1_epi32((int) (x))
+#define LOAD(p) _mm256_loadu_si256((const __m256i *) (p))
+#define STORE(p, x) _mm256_storeu_si256((__m256i *) (p), x)
+#define VROR(x, y) _mm256_or_si256(_mm256_srli_epi32(x, y), _mm256_slli_epi32(x, 32 - (y)))
+#define XOR3(x, y, z) _mm256_xor_si256(_mm256_xor_si256(x, y), z)
+#define CH(x, y, z) _mm256_xor_si256(z, _mm256_and_si256(x, _mm256_xor_si256(y, z)))
+#define MAJ(x, y, z) _mm256_or_si256(_mm256_and_si256(x, y), _mm256_and_si256(z, _mm256_or_si256(x, y)))
+#define S0(x) XOR3(VROR(x,  7), VROR(x, 18), _mm256_srli_epi32(x,  3))
+#define S1(x) XOR3(VROR(x, 17), VROR(x, 19), _mm256_srli_epi32(x, 10))
+#define T0(x) XOR3(VROR(x,  2), VROR(x, 13), VROR(x, 22))
+#define T1(x) XOR3(VROR(x,  6), VROR(x, 11), VROR(x, 25))
+
+__attribute__((target("avx2")))
+static void scan_avx2(const struct scan *scan, const uint32_t *w3, uint32_t *h7)
+{
+	SCAN_BODY();
+}
+
+#undef V
+#undef ADD
+#undef SET1
+#undef LOAD
+#undef STORE
+#undef VROR
+#undef XOR3
+#undef CH
+#undef MAJ
+#undef S0
+#undef S1
+#undef T0
+#undef T1
+
+#define V __m512i
+#define ADD(x, y) _mm512_add_epi32(x, y)
+#define SET1(x) _mm512_set1_epi32((int) (x))
+#define LOAD(p) _mm512_loadu_si512(p)
+#define STORE(p, x) _mm512_storeu_si512(p, x)
+#define VROR(x, y) _mm512_ror_epi32(x, y)
+#define XOR3(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0x96)
+#define CH(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0xCA)
+#define MAJ(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0xE8)
+#define S0(x) XOR3(VROR(x,  7), VROR(x, 18), _mm512_srli_epi32(x,  3))
+#define S1(x) XOR3(VROR(x, 17), VROR(x, 19), _mm512_srli_epi32(x, 10))
+#define T0(x) XOR3(VROR(x,  2), VROR(x, 13), VROR(x, 22))
+#define T1(x) XOR3(VROR(x,  6), VROR(x, 11), VROR(x, 25))
+
+__attribute__((target("avx512f")))
+static void scan_avx512(const struct scan *scan, const uint32_t *w3, uint32_t *h7)
+{
+	SCAN_BODY();
+}
+
+#endif
+
+/* The kernels have their own signature, so the table only names them; scan_kernels[] is in the same order. */
+const struct ampheck_lanes ampheck_sha256d_scan_lanes[] =
+{
+#ifdef AMPHECK_X86
+	{ "avx512", AMPHECK_CPU_AVX512F, 16, NULL },
+	{ "avx2", AMPHECK_CPU_AVX2, 8, NULL },
+#endif
+	{ "generic", 0, 1, NULL },
+	{ NULL, 0, 0, NULL }
+};
+
+static void (*const scan_kernels[])(const struct scan *, const uint32_t *, uint32_t *) =
+{
+#ifdef AMPHECK_X86
+	scan_avx512,
+	scan_avx2,
+#endif
+	scan_generic
+};
+
+/* Hashes the header with `nonce' in full and compares the digest, a little-endian number, against the target. */
+static int scan_check(const uint8_t *header, uint32_t nonce, const uint8_t *target)
+{
+	uint8_t copy[80];
+	uint8_t digest[32];
+	
+	memcpy(copy, header, 76);
+	UNPACK_32_LE(nonce, &copy[76]);
+	ampheck_sha256d(copy, 80, digest);
+	
+	for (int i = 31; i >= 0; --i)
+	{
+		if (digest[i] != target[i])
+		{
+			return digest[i] < target[i];
+		}
+	}
+	
+	return 1;
+}
+
+size_t ampheck_sha256d_scan(const uint8_t *header, uint32_t first, uint32_t last, const uint8_t *target, uint32_t *found, size_t max)
+{
+	static const struct ampheck_lanes *cached = NULL;
+	const struct ampheck_lanes *kernel = AMPHECK_LOAD(cached);
+	void (*scan_kernel)(const struct scan *, const uint32_t *, uint32_t *);
+	struct scan scan;
+	uint32_t nonce = first;
+	uint32_t top;
+	size_t matches = 0;
+	
+	if (kernel == NULL)
+	{
+		kernel = ampheck_lanes_select("sha256", ampheck_sha256d_scan_lanes);
+		AMPHECK_STORE(cached, kernel);
+	}
+	
+	if (first > last || max == 0)
+	{
+		return 0;
+	}
+	
+	scan_kernel = scan_kernels[kernel - ampheck_sha256d_scan_lanes];
+	scan_prepare(&scan, header);
+	PACK_32_LE(&target[28], &top);
+	
+	for (;;)
+	{
+		uint32_t w3[16];
+		uint32_t h7[16];
+		
+		for (unsigned int l = 0; l < kernel->lanes; ++l)
+		{
+			uint8_t bytes[4];
+			
+			UNPACK_32_LE((uint32_t) (nonce + l), bytes);
+			PACK_32_BE(bytes, &w3[l]);
+		}
+		
+		scan_kernel(&scan, w3, h7);
+		
+		for (unsigned int l = 0; l < kernel->lanes && l <= last - nonce; ++l)
+		{
+			uint8_t bytes[4];
+			uint32_t word;
+			
+			UNPACK_32_BE(h7[l], bytes);
+			PACK_32_LE(bytes, &word);
+			
+			if (word <= top && scan_check(header, nonce + l, target))
+			{
+				found[matches++] = nonce + l;
+				
+				if (matches == max)
+				{
+					return matches;
+				}
+			}
+		}
+		
+		if (last - nonce < kernel->lanes)
+		{
+			return matches;
+		}
+		
+		nonce += kernel->lanes;
+	}
+}
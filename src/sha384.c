@@ -17,51 +17,83 @@
 
 #include <stddef.h>
 #include <stdint.h>
-#include <string.h>
+
+#include <sys/uio.h>
 
 #include "ampheck.h"
+#include "backends.h"
 #include "sha384.h"
 #include "sha512.h"
 
+static const uint64_t sha384_iv[8] =
+{
+	0xcbbb9d5dc1059ed8, 0x629a292a367cd507, 0x9159015a3070dd17, 0x152fecd8f70e5939,
+	0x67332667ffc00b31, 0x8eb44a8768581511, 0xdb0c2e0d64f98fa7, 0x47b5481dbefa4fa4
+};
+
 void ampheck_sha384_init(struct ampheck_sha384 *ctx)
 {
-	ctx->h[0] = 0xcbbb9d5dc1059ed8;
-	ctx->h[1] = 0x629a292a367cd507;
-	ctx->h[2] = 0x9159015a3070dd17;
-	ctx->h[3] = 0x152fecd8f70e5939;
-	ctx->h[4] = 0x67332667ffc00b31;
-	ctx->h[5] = 0x8eb44a8768581511;
-	ctx->h[6] = 0xdb0c2e0d64f98fa7;
-	ctx->h[7] = 0x47b5481dbefa4fa4;
-	
-	ctx->length = 0;
+	ampheck_sha512t_init(&ctx->sha512, sha384_iv);
 }
 
+static void sha384_batch_init(void *ctx)
+{
+	ampheck_sha384_init(ctx);
+}
+
+/* SHA-512 with a shorter digest, on the same lanes. */
+static struct ampheck_batch sha384_batch =
+{
+	"sha512", ampheck_sha512_lanes, NULL, ampheck_sha512_batch_transform, sha384_batch_init,
+	sizeof(struct ampheck_sha384), offsetof(struct ampheck_sha384, sha512.buffer),
+	offsetof(struct ampheck_sha384, sha512.length), offsetof(struct ampheck_sha384, sha512.fill),
+	8, 8, 128, 48, 1
+};
+
 void ampheck_sha384_update(struct ampheck_sha384 *ctx, const uint8_t *data, size_t size)
 {
-	struct ampheck_sha512 context;
-	
-	memcpy(context.h,      ctx->h,       8 * sizeof(uint64_t));
-	memcpy(context.buffer, ctx->buffer, 64 * sizeof(uint8_t));
-	context.length = ctx->length;
-	
-	ampheck_sha512_update(&context, data, size);
-	
-	memcpy(ctx->h,      context.h,       8 * sizeof(uint64_t));
-	memcpy(ctx->buffer, context.buffer, 64 * sizeof(uint8_t));
-	ctx->length = context.length;
+	ampheck_sha512_update(&ctx->sha512, data, size);
+}
+
+void ampheck_sha384_updatev(struct ampheck_sha384 *ctx, const struct iovec *iov, int iovcnt)
+{
+	ampheck_sha512_updatev(&ctx->sha512, iov, iovcnt);
 }
 
 void ampheck_sha384_finish(const struct ampheck_sha384 *ctx, uint8_t *digest)
 {
-	uint8_t final[64];
-	struct ampheck_sha512 context;
-	
-	memcpy(context.h,      ctx->h,       8 * sizeof(uint64_t));
-	memcpy(context.buffer, ctx->buffer, 64 * sizeof(uint8_t));
-	context.length = ctx->length;
-	
-	ampheck_sha512_finish(&context, final);
-	
-	memcpy(digest, final, 48);
+	ampheck_sha512t_finish(&ctx->sha512, digest, 48);
+}
+
+void ampheck_sha384_finish_inplace(struct ampheck_sha384 *ctx, uint8_t *digest)
+{
+	ampheck_sha512t_finish_inplace(&ctx->sha512, digest, 48);
+}
+
+void ampheck_sha384_digest(const uint8_t *data, size_t length, uint8_t *digest)
+{
+	ampheck_sha512t_digest(sha384_iv, data, length, digest, 48);
+}
+
+void ampheck_sha384_init_batch(struct ampheck_sha384 *ctx, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		ampheck_sha384_init(&ctx[i]);
+	}
+}
+
+void ampheck_sha384_update_batch(struct ampheck_sha384 *ctx, const uint8_t *const data[], const size_t length[], size_t count)
+{
+	ampheck_batch_update(&sha384_batch, ctx, data, length, count);
+}
+
+void ampheck_sha384_finish_batch(const struct ampheck_sha384 *ctx, uint8_t *const digest[], size_t count)
+{
+	ampheck_batch_finish(&sha384_batch, ctx, digest, count);
+}
+
+void ampheck_sha384_mgr_init(struct ampheck_mgr *mgr)
+{
+	ampheck_mgr_init(mgr, &sha384_batch);
 }
@@ -21,16 +21,28 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "mgr.h"
+#include "sha512.h"
+
+struct iovec;
+
+/* SHA-512 with another IV and a shorter digest, on the same context. */
 struct ampheck_sha384
 {
-	uint64_t h[8];
-	uint8_t buffer[128];
-	
-	uint64_t length;
+	struct ampheck_sha512 sha512;
 };
 
 void ampheck_sha384_init(struct ampheck_sha384 *ctx);
 void ampheck_sha384_update(struct ampheck_sha384 *ctx, const uint8_t *data, size_t length);
+void ampheck_sha384_updatev(struct ampheck_sha384 *ctx, const struct iovec *iov, int iovcnt);
 void ampheck_sha384_finish(const struct ampheck_sha384 *ctx, uint8_t *digest);
+void ampheck_sha384_finish_inplace(struct ampheck_sha384 *ctx, uint8_t *digest);
+void ampheck_sha384_digest(const uint8_t *data, size_t length, uint8_t *digest);
+
+/* Batch versions over arrays of contexts; see sha256.h. */
+void ampheck_sha384_init_batch(struct ampheck_sha384 *ctx, size_t count);
+void ampheck_sha384_update_batch(struct ampheck_sha384 *ctx, const uint8_t *const data[], const size_t length[], size_t count);
+void ampheck_sha384_finish_batch(const struct ampheck_sha384 *ctx, uint8_t *const digest[], size_t count);
+void ampheck_sha384_mgr_init(struct ampheck_mgr *mgr);
 
 #endif
@@ -19,7 +19,10 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <sys/uio.h>
+
 #include "ampheck.h"
+#include "backends.h"
 #include "sha512.h"
 
 #define CH(x, y, z) (z ^ (x & (y ^ z)))
@@ -40,43 +43,40 @@
 	w[i] += SHA512_S0(w[(i + 1) & 0x0F]) + SHA512_S1(w[(i - 2) & 0x0F]) + w[(i - 7) & 0x0F] \
 )
 
+static const uint64_t sha512_iv[8] =
+{
+	0x6a09e667f3bcc908, 0xbb67ae8584caa73b, 0x3c6ef372fe94f82b, 0xa54ff53a5f1d36f1,
+	0x510e527fade682d1, 0x9b05688c2b3e6c1f, 0x1f83d9abfb41bd6b, 0x5be0cd19137e2179
+};
+
 void ampheck_sha512_init(struct ampheck_sha512 *ctx)
 {
-	ctx->h[0] = 0x6a09e667f3bcc908;
-	ctx->h[1] = 0xbb67ae8584caa73b;
-	ctx->h[2] = 0x3c6ef372fe94f82b;
-	ctx->h[3] = 0xa54ff53a5f1d36f1;
-	ctx->h[4] = 0x510e527fade682d1;
-	ctx->h[5] = 0x9b05688c2b3e6c1f;
-	ctx->h[6] = 0x1f83d9abfb41bd6b;
-	ctx->h[7] = 0x5be0cd19137e2179;
-	
-	ctx->length = 0;
+	ampheck_sha512t_init(ctx, sha512_iv);
 }
 
-void ampheck_sha512_transform(struct ampheck_sha512 *ctx, const uint8_t *data, size_t blocks)
+void ampheck_sha512_transform_generic(struct ampheck_sha512 *ctx, const uint8_t *data, size_t blocks)
 {
 	for (size_t i = 0; i < blocks; ++i)
 	{
 		uint64_t wv[8];
 		uint64_t w[16];
 		
-		PACK_64_BE(&data[(i << 6)      ], &w[ 0]);
-		PACK_64_BE(&data[(i << 6) +   8], &w[ 1]);
-		PACK_64_BE(&data[(i << 6) +  16], &w[ 2]);
-		PACK_64_BE(&data[(i << 6) +  24], &w[ 3]);
-		PACK_64_BE(&data[(i << 6) +  32], &w[ 4]);
-		PACK_64_BE(&data[(i << 6) +  40], &w[ 5]);
-		PACK_64_BE(&data[(i << 6) +  48], &w[ 6]);
-		PACK_64_BE(&data[(i << 6) +  56], &w[ 7]);
-		PACK_64_BE(&data[(i << 6) +  64], &w[ 8]);
-		PACK_64_BE(&data[(i << 6) +  72], &w[ 9]);
-		PACK_64_BE(&data[(i << 6) +  80], &w[10]);
-		PACK_64_BE(&data[(i << 6) +  88], &w[11]);
-		PACK_64_BE(&data[(i << 6) +  96], &w[12]);
-		PACK_64_BE(&data[(i << 6) + 104], &w[13]);
-		PACK_64_BE(&data[(i << 6) + 112], &w[14]);
-		PACK_64_BE(&data[(i << 6) + 120], &w[15]);
+		PACK_64_BE(&data[(i << 7)      ], &w[ 0]);
+		PACK_64_BE(&data[(i << 7) +   8], &w[ 1]);
+		PACK_64_BE(&data[(i << 7) +  16], &w[ 2]);
+		PACK_64_BE(&data[(i << 7) +  24], &w[ 3]);
+		PACK_64_BE(&data[(i << 7) +  32], &w[ 4]);
+		PACK_64_BE(&data[(i << 7) +  40], &w[ 5]);
+		PACK_64_BE(&data[(i << 7) +  48], &w[ 6]);
+		PACK_64_BE(&data[(i << 7) +  56], &w[ 7]);
+		PACK_64_BE(&data[(i << 7) +  64], &w[ 8]);
+		PACK_64_BE(&data[(i << 7) +  72], &w[ 9]);
+		PACK_64_BE(&data[(i << 7) +  80], &w[10]);
+		PACK_64_BE(&data[(i << 7) +  88], &w[11]);
+		PACK_64_BE(&data[(i << 7) +  96], &w[12]);
+		PACK_64_BE(&data[(i << 7) + 104], &w[13]);
+		PACK_64_BE(&data[(i << 7) + 112], &w[14]);
+		PACK_64_BE(&data[(i << 7) + 120], &w[15]);
 		
 		wv[0] = ctx->h[0];
 		wv[1] = ctx->h[1];
@@ -180,63 +180,229 @@ void ampheck_sha512_transform(struct ampheck_sha512 *ctx, const uint8_t *data, s
 	}
 }
 
-void ampheck_sha512_update(struct ampheck_sha512 *ctx, const uint8_t *data, size_t size)
+const struct ampheck_backend ampheck_sha512_backends[] =
 {
-	size_t tmp = size;
+#ifdef AMPHECK_X86
+	{ "avx512", AMPHECK_CPU_AVX512VL | AMPHECK_CPU_BMI2, (ampheck_backend_fn) ampheck_sha512_transform_avx512 },
+	{ "avx2", AMPHECK_CPU_AVX2 | AMPHECK_CPU_BMI2, (ampheck_backend_fn) ampheck_sha512_transform_avx2 },
+#endif
+	{ "generic", 0, (ampheck_backend_fn) ampheck_sha512_transform_generic },
+	{ NULL, 0, NULL }
+};
+
+void ampheck_sha512_transform(struct ampheck_sha512 *ctx, const uint8_t *data, size_t blocks)
+{
+	static void (*transform)(struct ampheck_sha512 *, const uint8_t *, size_t) = NULL;
+	void (*selected)(struct ampheck_sha512 *, const uint8_t *, size_t) = AMPHECK_LOAD(transform);
 	
-	if (size >= 128 - ctx->length % 128)
+	if (selected == NULL)
 	{
-		memcpy(&ctx->buffer[ctx->length % 128], data, 128 - ctx->length % 128);
+		selected = (void (*)(struct ampheck_sha512 *, const uint8_t *, size_t)) ampheck_backend_select("sha512", ampheck_sha512_backends)->transform;
+		AMPHECK_STORE(transform, selected);
+	}
+	
+	selected(ctx, data, blocks);
+}
+
+const struct ampheck_lanes ampheck_sha512_lanes[] =
+{
+#ifdef AMPHECK_X86
+	{ "avx512", AMPHECK_CPU_AVX512F, 8, ampheck_sha512_lanes_avx512 },
+	{ "avx2", AMPHECK_CPU_AVX2, 4, ampheck_sha512_lanes_avx2 },
+#endif
+	{ "generic", 0, 1, NULL },
+	{ NULL, 0, 0, NULL }
+};
+
+void ampheck_sha512_batch_transform(void *h, const uint8_t *data, size_t blocks)
+{
+	struct ampheck_sha512 ctx;
+	
+	memcpy(ctx.h, h, sizeof(ctx.h));
+	ampheck_sha512_transform(&ctx, data, blocks);
+	memcpy(h, ctx.h, sizeof(ctx.h));
+}
+
+static void sha512_batch_init(void *ctx)
+{
+	ampheck_sha512_init(ctx);
+}
+
+static struct ampheck_batch sha512_batch =
+{
+	"sha512", ampheck_sha512_lanes, NULL, ampheck_sha512_batch_transform, sha512_batch_init,
+	sizeof(struct ampheck_sha512), offsetof(struct ampheck_sha512, buffer),
+	offsetof(struct ampheck_sha512, length), offsetof(struct ampheck_sha512, fill),
+	8, 8, 128, 64, 1
+};
+
+static void __attribute__((noinline)) sha512_update_blocks(struct ampheck_sha512 *ctx, const uint8_t *data, size_t size)
+{
+	if (ctx->fill > 0)
+	{
+		memcpy(&ctx->buffer[ctx->fill], data, 128 - ctx->fill);
 		
-		data += 128 - ctx->length % 128;
-		size -= 128 - ctx->length % 128;
+		data += 128 - ctx->fill;
+		size -= 128 - ctx->fill;
 		
 		ampheck_sha512_transform(ctx, ctx->buffer, 1);
-		ampheck_sha512_transform(ctx, data, size / 128);
-		
-		data += size & ~127;
-		size %= 128;
+	}
+	
+	ampheck_sha512_transform(ctx, data, size / 128);
+	
+	data += size & ~(size_t) 127;
+	ctx->fill = (uint32_t) (size % 128);
+	
+	memcpy(ctx->buffer, data, ctx->fill);
+}
+
+void ampheck_sha512_update(struct ampheck_sha512 *ctx, const uint8_t *data, size_t size)
+{
+	ctx->length += size;
+	
+	if (size < 128 - ctx->fill)
+	{
+		uint8_t *p = &ctx->buffer[ctx->fill];
 		
-		memcpy(ctx->buffer, data, size);
+		ctx->fill += (uint32_t) size;
+		memcpy(p, data, size);
 	}
 	else
 	{
-		memcpy(&ctx->buffer[ctx->length % 128], data, size);
+		sha512_update_blocks(ctx, data, size);
+	}
+}
+
+void ampheck_sha512_updatev(struct ampheck_sha512 *ctx, const struct iovec *iov, int iovcnt)
+{
+	for (int i = 0; i < iovcnt; ++i)
+	{
+		ampheck_sha512_update(ctx, iov[i].iov_base, iov[i].iov_len);
 	}
-	
-	ctx->length += tmp;
 }
 
 void ampheck_sha512_finish(const struct ampheck_sha512 *ctx, uint8_t *digest)
 {
 	struct ampheck_sha512 tmp;
 	
-	memcpy(tmp.h, ctx->h, 8 * sizeof(uint64_t));
-	memcpy(tmp.buffer, ctx->buffer, ctx->length % 128);
+	memcpy(tmp.h, ctx->h, sizeof(tmp.h));
+	memcpy(tmp.buffer, ctx->buffer, ctx->fill);
+	tmp.length = ctx->length;
+	tmp.fill = ctx->fill;
 	
-	tmp.buffer[ctx->length % 128] = 0x80;
+	ampheck_sha512_finish_inplace(&tmp, digest);
+}
+
+void ampheck_sha512_finish_inplace(struct ampheck_sha512 *ctx, uint8_t *digest)
+{
+	ctx->buffer[ctx->fill] = 0x80;
 	
-	if (ctx->length % 128 < 112)
+	if (ctx->fill < 112)
 	{
-		memset(&tmp.buffer[ctx->length % 128 + 1], 0x00, 119 - ctx->length % 128);
+		memset(&ctx->buffer[ctx->fill + 1], 0x00, 119 - ctx->fill);
 	}
 	else
 	{
-		memset(&tmp.buffer[ctx->length % 128 + 1], 0x00, 127 - ctx->length % 128);
-		ampheck_sha512_transform(&tmp, tmp.buffer, 1);
+		memset(&ctx->buffer[ctx->fill + 1], 0x00, 127 - ctx->fill);
+		ampheck_sha512_transform(ctx, ctx->buffer, 1);
 		
-		memset(tmp.buffer, 0x00, 120);
+		memset(ctx->buffer, 0x00, 120);
 	}
 	
-	UNPACK_64_BE(ctx->length * 8, &tmp.buffer[120]);
-	ampheck_sha512_transform(&tmp, tmp.buffer, 1);
-	
-	UNPACK_64_BE(tmp.h[0], &digest[ 0]);
-	UNPACK_64_BE(tmp.h[1], &digest[ 8]);
-	UNPACK_64_BE(tmp.h[2], &digest[16]);
-	UNPACK_64_BE(tmp.h[3], &digest[24]);
-	UNPACK_64_BE(tmp.h[4], &digest[32]);
-	UNPACK_64_BE(tmp.h[5], &digest[40]);
-	UNPACK_64_BE(tmp.h[6], &digest[48]);
-	UNPACK_64_BE(tmp.h[7], &digest[56]);
+	UNPACK_64_BE(ctx->length * 8, &ctx->buffer[120]);
+	ampheck_sha512_transform(ctx, ctx->buffer, 1);
+	
+	UNPACK_64_BE(ctx->h[0], &digest[ 0]);
+	UNPACK_64_BE(ctx->h[1], &digest[ 8]);
+	UNPACK_64_BE(ctx->h[2], &digest[16]);
+	UNPACK_64_BE(ctx->h[3], &digest[24]);
+	UNPACK_64_BE(ctx->h[4], &digest[32]);
+	UNPACK_64_BE(ctx->h[5], &digest[40]);
+	UNPACK_64_BE(ctx->h[6], &digest[48]);
+	UNPACK_64_BE(ctx->h[7], &digest[56]);
+}
+
+void ampheck_sha512_digest(const uint8_t *data, size_t length, uint8_t *digest)
+{
+	ampheck_sha512t_digest(sha512_iv, data, length, digest, 64);
+}
+
+/*
+	SHA-384, SHA-512/224 and SHA-512/256 are SHA-512 from another IV, with
+	the digest cut to its first `size' bytes.
+*/
+void ampheck_sha512t_init(struct ampheck_sha512 *ctx, const uint64_t iv[8])
+{
+	memcpy(ctx->h, iv, sizeof(ctx->h));
+	
+	ctx->length = 0;
+	ctx->fill = 0;
+}
+
+void ampheck_sha512t_finish(const struct ampheck_sha512 *ctx, uint8_t *digest, size_t size)
+{
+	uint8_t final[64];
+	
+	ampheck_sha512_finish(ctx, final);
+	
+	memcpy(digest, final, size);
+}
+
+void ampheck_sha512t_finish_inplace(struct ampheck_sha512 *ctx, uint8_t *digest, size_t size)
+{
+	uint8_t final[64];
+	
+	ampheck_sha512_finish_inplace(ctx, final);
+	
+	memcpy(digest, final, size);
+}
+
+void ampheck_sha512t_digest(const uint64_t iv[8], const uint8_t *data, size_t length, uint8_t *digest, size_t size)
+{
+	struct ampheck_sha512 ctx;
+	uint8_t final[256];
+	
+	memcpy(ctx.h, iv, sizeof(ctx.h));
+	
+	if (length >= 128)
+	{
+		ampheck_sha512_transform(&ctx, data, length / 128);
+	}
+	
+	ampheck_sha512_transform(&ctx, final, ampheck_final(final, &data[length & ~(size_t) 127], length, 128, 1));
+	
+	for (size_t j = 0; j < size / 8; ++j)
+	{
+		UNPACK_64_BE(ctx.h[j], &digest[j * 8]);
+	}
+	
+	/* SHA-512/224 ends in the high half of a word. */
+	if (size % 8 != 0)
+	{
+		UNPACK_64_BE(ctx.h[size / 8], final);
+		memcpy(&digest[size & ~(size_t) 7], final, size % 8);
+	}
+}
+
+void ampheck_sha512_init_batch(struct ampheck_sha512 *ctx, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		ampheck_sha512_init(&ctx[i]);
+	}
+}
+
+void ampheck_sha512_update_batch(struct ampheck_sha512 *ctx, const uint8_t *const data[], const size_t length[], size_t count)
+{
+	ampheck_batch_update(&sha512_batch, ctx, data, length, count);
+}
+
+void ampheck_sha512_finish_batch(const struct ampheck_sha512 *ctx, uint8_t *const digest[], size_t count)
+{
+	ampheck_batch_finish(&sha512_batch, ctx, digest, count);
+}
+
+void ampheck_sha512_mgr_init(struct ampheck_mgr *mgr)
+{
+	ampheck_mgr_init(mgr, &sha512_batch);
 }
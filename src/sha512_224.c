@@ -0,0 +1,99 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <sys/uio.h>
+
+#include "ampheck.h"
+#include "backends.h"
+#include "sha512_224.h"
+#include "sha512.h"
+
+static const uint64_t sha512_224_iv[8] =
+{
+	0x8c3d37c819544da2, 0x73e1996689dcd4d6, 0x1dfab7ae32ff9c82, 0x679dd514582f9fcf,
+	0x0f6d2b697bd44da8, 0x77e36f7304c48942, 0x3f9d85a86a1d36c8, 0x1112e6ad91d692a1
+};
+
+void ampheck_sha512_224_init(struct ampheck_sha512_224 *ctx)
+{
+	ampheck_sha512t_init(&ctx->sha512, sha512_224_iv);
+}
+
+static void sha512_224_batch_init(void *ctx)
+{
+	ampheck_sha512_224_init(ctx);
+}
+
+/* SHA-512 with a shorter digest, on the same lanes. */
+static struct ampheck_batch sha512_224_batch =
+{
+	"sha512", ampheck_sha512_lanes, NULL, ampheck_sha512_batch_transform, sha512_224_batch_init,
+	sizeof(struct ampheck_sha512_224), offsetof(struct ampheck_sha512_224, sha512.buffer),
+	offsetof(struct ampheck_sha512_224, sha512.length), offsetof(struct ampheck_sha512_224, sha512.fill),
+	8, 8, 128, 28, 1
+};
+
+void ampheck_sha512_224_update(struct ampheck_sha512_224 *ctx, const uint8_t *data, size_t size)
+{
+	ampheck_sha512_update(&ctx->sha512, data, size);
+}
+
+void ampheck_sha512_224_updatev(struct ampheck_sha512_224 *ctx, const struct iovec *iov, int iovcnt)
+{
+	ampheck_sha512_updatev(&ctx->sha512, iov, iovcnt);
+}
+
+void ampheck_sha512_224_finish(const struct ampheck_sha512_224 *ctx, uint8_t *digest)
+{
+	ampheck_sha512t_finish(&ctx->sha512, digest, 28);
+}
+
+void ampheck_sha512_224_finish_inplace(struct ampheck_sha512_224 *ctx, uint8_t *digest)
+{
+	ampheck_sha512t_finish_inplace(&ctx->sha512, digest, 28);
+}
+
+void ampheck_sha512_224_digest(const uint8_t *data, size_t length, uint8_t *digest)
+{
+	ampheck_sha512t_digest(sha512_224_iv, data, length, digest, 28);
+}
+
+void ampheck_sha512_224_init_batch(struct ampheck_sha512_224 *ctx, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		ampheck_sha512_224_init(&ctx[i]);
+	}
+}
+
+void ampheck_sha512_224_update_batch(struct ampheck_sha512_224 *ctx, const uint8_t *const data[], const size_t length[], size_t count)
+{
+	ampheck_batch_update(&sha512_224_batch, ctx, data, length, count);
+}
+
+void ampheck_sha512_224_finish_batch(const struct ampheck_sha512_224 *ctx, uint8_t *const digest[], size_t count)
+{
+	ampheck_batch_finish(&sha512_224_batch, ctx, digest, count);
+}
+
+void ampheck_sha512_224_mgr_init(struct ampheck_mgr *mgr)
+{
+	ampheck_mgr_init(mgr, &sha512_224_batch);
+}
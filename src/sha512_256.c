@@ -0,0 +1,99 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <sys/uio.h>
+
+#include "ampheck.h"
+#include "backends.h"
+#include "sha512_256.h"
+#include "sha512.h"
+
+static const uint64_t sha512_256_iv[8] =
+{
+	0x22312194fc2bf72c, 0x9f555fa3c84c64c2, 0x2393b86b6f53b151, 0x963877195940eabd,
+	0x96283ee2a88effe3, 0xbe5e1e2553863992, 0x2b0199fc2c85b8aa, 0x0eb72ddc81c52ca2
+};
+
+void ampheck_sha512_256_init(struct ampheck_sha512_256 *ctx)
+{
+	ampheck_sha512t_init(&ctx->sha512, sha512_256_iv);
+}
+
+static void sha512_256_batch_init(void *ctx)
+{
+	ampheck_sha512_256_init(ctx);
+}
+
+/* SHA-512 with a shorter digest, on the same lanes. */
+static struct ampheck_batch sha512_256_batch =
+{
+	"sha512", ampheck_sha512_lanes, NULL, ampheck_sha512_batch_transform, sha512_256_batch_init,
+	sizeof(struct ampheck_sha512_256), offsetof(struct ampheck_sha512_256, sha512.buffer),
+	offsetof(struct ampheck_sha512_256, sha512.length), offsetof(struct ampheck_sha512_256, sha512.fill),
+	8, 8, 128, 32, 1
+};
+
+void ampheck_sha512_256_update(struct ampheck_sha512_256 *ctx, const uint8_t *data, size_t size)
+{
+	ampheck_sha512_update(&ctx->sha512, data, size);
+}
+
+void ampheck_sha512_256_updatev(struct ampheck_sha512_256 *ctx, const struct iovec *iov, int iovcnt)
+{
+	ampheck_sha512_updatev(&ctx->sha512, iov, iovcnt);
+}
+
+void ampheck_sha512_256_finish(const struct ampheck_sha512_256 *ctx, uint8_t *digest)
+{
+	ampheck_sha512t_finish(&ctx->sha512, digest, 32);
+}
+
+void ampheck_sha512_256_finish_inplace(struct ampheck_sha512_256 *ctx, uint8_t *digest)
+{
+	ampheck_sha512t_finish_inplace(&ctx->sha512, digest, 32);
+}
+
+void ampheck_sha512_256_digest(const uint8_t *data, size_t length, uint8_t *digest)
+{
+	ampheck_sha512t_digest(sha512_256_iv, data, length, digest, 32);
+}
+
+void ampheck_sha512_256_init_batch(struct ampheck_sha512_256 *ctx, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		ampheck_sha512_256_init(&ctx[i]);
+	}
+}
+
+void ampheck_sha512_256_update_batch(struct ampheck_sha512_256 *ctx, const uint8_t *const data[], const size_t length[], size_t count)
+{
+	ampheck_batch_update(&sha512_256_batch, ctx, data, length, count);
+}
+
+void ampheck_sha512_256_finish_batch(const struct ampheck_sha512_256 *ctx, uint8_t *const digest[], size_t count)
+{
+	ampheck_batch_finish(&sha512_256_batch, ctx, digest, count);
+}
+
+void ampheck_sha512_256_mgr_init(struct ampheck_mgr *mgr)
+{
+	ampheck_mgr_init(mgr, &sha512_256_batch);
+}
@@ -0,0 +1,48 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ampheck_sha512_256_h
+#define ampheck_sha512_256_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mgr.h"
+#include "sha512.h"
+
+struct iovec;
+
+/* SHA-512/256: SHA-512 with another IV and a truncated digest, on the same context. */
+struct ampheck_sha512_256
+{
+	struct ampheck_sha512 sha512;
+};
+
+void ampheck_sha512_256_init(struct ampheck_sha512_256 *ctx);
+void ampheck_sha512_256_update(struct ampheck_sha512_256 *ctx, const uint8_t *data, size_t length);
+void ampheck_sha512_256_updatev(struct ampheck_sha512_256 *ctx, const struct iovec *iov, int iovcnt);
+void ampheck_sha512_256_finish(const struct ampheck_sha512_256 *ctx, uint8_t *digest);
+void ampheck_sha512_256_finish_inplace(struct ampheck_sha512_256 *ctx, uint8_t *digest);
+void ampheck_sha512_256_digest(const uint8_t *data, size_t length, uint8_t *digest);
+
+/* Batch versions over arrays of contexts; see sha256.h. */
+void ampheck_sha512_256_init_batch(struct ampheck_sha512_256 *ctx, size_t count);
+void ampheck_sha512_256_update_batch(struct ampheck_sha512_256 *ctx, const uint8_t *const data[], const size_t length[], size_t count);
+void ampheck_sha512_256_finish_batch(const struct ampheck_sha512_256 *ctx, uint8_t *const digest[], size_t count);
+void ampheck_sha512_256_mgr_init(struct ampheck_mgr *mgr);
+
+#endif
@@ -0,0 +1,194 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ampheck.h"
+#include "backends.h"
+#include "sha512.h"
+
+#ifdef AMPHECK_X86
+
+#include <immintrin.h>
+
+/*
+	The 80-word message schedule is expanded four words at a time and stored
+	with the round constants already added; the rounds stay scalar and use
+	RORX.  The AVX-512 variant gets VPRORQ and VPTERNLOGQ for the schedule.
+*/
+
+#define CH(x, y, z) (z ^ (x & (y ^ z)))
+#define MAJ(x, y, z) ((x & y) | (z & (x | y)))
+
+#define SHA512_T0(x) (ROR(x, 28) ^ ROR(x, 34) ^ ROR(x, 39))
+#define SHA512_T1(x) (ROR(x, 14) ^ ROR(x, 18) ^ ROR(x, 41))
+
+#define SHA512_PRC(a, b, c, d, e, f, g, h, wk) { \
+	uint64_t t1 = wv[h] + SHA512_T1(wv[e]) + CH(wv[e], wv[f], wv[g]) + wk; \
+	wv[d] += t1; \
+	wv[h]  = t1 + SHA512_T0(wv[a]) + MAJ(wv[a], wv[b], wv[c]); \
+}
+
+#define SHA512_AVX2_ROR(x, y) _mm256_or_si256(_mm256_srli_epi64(x, y), _mm256_slli_epi64(x, 64 - (y)))
+#define SHA512_AVX2_XOR3(x, y, z) _mm256_xor_si256(_mm256_xor_si256(x, y), z)
+
+#define SHA512_AVX512_ROR(x, y) _mm256_ror_epi64(x, y)
+#define SHA512_AVX512_XOR3(x, y, z) _mm256_ternarylogic_epi64(x, y, z, 0x96)
+
+#define SHA512_VEC_S0(x, isa) SHA512_##isa##_XOR3(SHA512_##isa##_ROR(x,  1), SHA512_##isa##_ROR(x,  8), _mm256_srli_epi64(x, 7))
+#define SHA512_VEC_S1(x, isa) SHA512_##isa##_XOR3(SHA512_##isa##_ROR(x, 19), SHA512_##isa##_ROR(x, 61), _mm256_srli_epi64(x, 6))
+
+/* Computes W[t..t+3] from W[t-16..t-1]; the last two words need the first two. */
+#define SHA512_VEC_EXT(x0, x1, x2, x3, isa) { \
+	__m256i t, l, h; \
+	\
+	t = _mm256_alignr_epi8(_mm256_permute2x128_si256(x2, x3, 0x21), x2, 8); \
+	t = _mm256_add_epi64(_mm256_add_epi64(x0, t), SHA512_VEC_S0(_mm256_alignr_epi8(_mm256_permute2x128_si256(x0, x1, 0x21), x0, 8), isa)); \
+	\
+	l = _mm256_permute2x128_si256(x3, x3, 0x11); \
+	l = _mm256_add_epi64(t, SHA512_VEC_S1(l, isa)); \
+	\
+	h = _mm256_permute2x128_si256(l, l, 0x00); \
+	h = _mm256_add_epi64(t, SHA512_VEC_S1(h, isa)); \
+	\
+	x0 = _mm256_blend_epi32(l, h, 0xF0); \
+}
+
+#define SHA512_VEC_LOAD(x, g) { \
+	x = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *) &data[(g) << 5]), mask); \
+	_mm256_store_si256((__m256i *) &wk[(g) << 2], _mm256_add_epi64(x, _mm256_loadu_si256((const __m256i *) &sha512_k[(g) << 2]))); \
+}
+
+#define SHA512_VEC_STORE(x, g) { \
+	_mm256_store_si256((__m256i *) &wk[(g) << 2], _mm256_add_epi64(x, _mm256_loadu_si256((const __m256i *) &sha512_k[(g) << 2]))); \
+}
+
+#define SHA512_VEC_SCHEDULE(isa) { \
+	const __m256i mask = _mm256_set_epi64x(0x08090a0b0c0d0e0fULL, 0x0001020304050607ULL, \
+	                                       0x08090a0b0c0d0e0fULL, 0x0001020304050607ULL); \
+	__m256i x0, x1, x2, x3; \
+	\
+	SHA512_VEC_LOAD(x0, 0); \
+	SHA512_VEC_LOAD(x1, 1); \
+	SHA512_VEC_LOAD(x2, 2); \
+	SHA512_VEC_LOAD(x3, 3); \
+	\
+	for (size_t g = 4; g < 20; g += 4) \
+	{ \
+		SHA512_VEC_EXT(x0, x1, x2, x3, isa); SHA512_VEC_STORE(x0, g    ); \
+		SHA512_VEC_EXT(x1, x2, x3, x0, isa); SHA512_VEC_STORE(x1, g + 1); \
+		SHA512_VEC_EXT(x2, x3, x0, x1, isa); SHA512_VEC_STORE(x2, g + 2); \
+		SHA512_VEC_EXT(x3, x0, x1, x2, isa); SHA512_VEC_STORE(x3, g + 3); \
+	} \
+}
+
+static const uint64_t sha512_k[80] =
+{
+	0x428a2f98d728ae22, 0x7137449123ef65cd, 0xb5c0fbcfec4d3b2f, 0xe9b5dba58189dbbc,
+	0x3956c25bf348b538, 0x59f111f1b605d019, 0x923f82a4af194f9b, 0xab1c5ed5da6d8118,
+	0xd807aa98a3030242, 0x12835b0145706fbe, 0x243185be4ee4b28c, 0x550c7dc3d5ffb4e2,
+	0x72be5d74f27b896f, 0x80deb1fe3b1696b1, 0x9bdc06a725c71235, 0xc19bf174cf692694,
+	0xe49b69c19ef14ad2, 0xefbe4786384f25e3, 0x0fc19dc68b8cd5b5, 0x240ca1cc77ac9c65,
+	0x2de92c6f592b0275, 0x4a7484aa6ea6e483, 0x5cb0a9dcbd41fbd4, 0x76f988da831153b5,
+	0x983e5152ee66dfab, 0xa831c66d2db43210, 0xb00327c898fb213f, 0xbf597fc7beef0ee4,
+	0xc6e00bf33da88fc2, 0xd5a79147930aa725, 0x06ca6351e003826f, 0x142929670a0e6e70,
+	0x27b70a8546d22ffc, 0x2e1b21385c26c926, 0x4d2c6dfc5ac42aed, 0x53380d139d95b3df,
+	0x650a73548baf63de, 0x766a0abb3c77b2a8, 0x81c2c92e47edaee6, 0x92722c851482353b,
+	0xa2bfe8a14cf10364, 0xa81a664bbc423001, 0xc24b8b70d0f89791, 0xc76c51a30654be30,
+	0xd192e819d6ef5218, 0xd69906245565a910, 0xf40e35855771202a, 0x106aa07032bbd1b8,
+	0x19a4c116b8d2d0c8, 0x1e376c085141ab53, 0x2748774cdf8eeb99, 0x34b0bcb5e19b48a8,
+	0x391c0cb3c5c95a63, 0x4ed8aa4ae3418acb, 0x5b9cca4f7763e373, 0x682e6ff3d6b2b8a3,
+	0x748f82ee5defb2fc, 0x78a5636f43172f60, 0x84c87814a1f0ab72, 0x8cc702081a6439ec,
+	0x90befffa23631e28, 0xa4506cebde82bde9, 0xbef9a3f7b2c67915, 0xc67178f2e372532b,
+	0xca273eceea26619c, 0xd186b8c721c0c207, 0xeada7dd6cde0eb1e, 0xf57d4f7fee6ed178,
+	0x06f067aa72176fba, 0x0a637dc5a2c898a6, 0x113f9804bef90dae, 0x1b710b35131c471b,
+	0x28db77f523047d84, 0x32caab7b40c72493, 0x3c9ebe0a15c9bebc, 0x431d67c49c100d4c,
+	0x4cc5d4becb3e42b6, 0x597f299cfc657e2a, 0x5fcb6fab3ad6faec, 0x6c44198c4a475817
+};
+
+__attribute__((target("avx2")))
+static void sha512_schedule_avx2(uint64_t *wk, const uint8_t *data)
+{
+	SHA512_VEC_SCHEDULE(AVX2);
+}
+
+__attribute__((target("avx2,avx512f,avx512vl")))
+static void sha512_schedule_avx512(uint64_t *wk, const uint8_t *data)
+{
+	SHA512_VEC_SCHEDULE(AVX512);
+}
+
+__attribute__((target("bmi2")))
+static void sha512_rounds(uint64_t *h, const uint64_t *wk)
+{
+	uint64_t wv[8];
+	
+	wv[0] = h[0];
+	wv[1] = h[1];
+	wv[2] = h[2];
+	wv[3] = h[3];
+	wv[4] = h[4];
+	wv[5] = h[5];
+	wv[6] = h[6];
+	wv[7] = h[7];
+	
+	for (size_t t = 0; t < 80; t += 8)
+	{
+		SHA512_PRC(0, 1, 2, 3, 4, 5, 6, 7, wk[t    ]);
+		SHA512_PRC(7, 0, 1, 2, 3, 4, 5, 6, wk[t + 1]);
+		SHA512_PRC(6, 7, 0, 1, 2, 3, 4, 5, wk[t + 2]);
+		SHA512_PRC(5, 6, 7, 0, 1, 2, 3, 4, wk[t + 3]);
+		SHA512_PRC(4, 5, 6, 7, 0, 1, 2, 3, wk[t + 4]);
+		SHA512_PRC(3, 4, 5, 6, 7, 0, 1, 2, wk[t + 5]);
+		SHA512_PRC(2, 3, 4, 5, 6, 7, 0, 1, wk[t + 6]);
+		SHA512_PRC(1, 2, 3, 4, 5, 6, 7, 0, wk[t + 7]);
+	}
+	
+	h[0] += wv[0];
+	h[1] += wv[1];
+	h[2] += wv[2];
+	h[3] += wv[3];
+	h[4] += wv[4];
+	h[5] += wv[5];
+	h[6] += wv[6];
+	h[7] += wv[7];
+}
+
+void ampheck_sha512_transform_avx2(struct ampheck_sha512 *ctx, const uint8_t *data, size_t blocks)
+{
+	uint64_t wk[80] __attribute__((aligned(32)));
+	
+	for (size_t i = 0; i < blocks; ++i)
+	{
+		sha512_schedule_avx2(wk, &data[i << 7]);
+		sha512_rounds(ctx->h, wk);
+	}
+}
+
+void ampheck_sha512_transform_avx512(struct ampheck_sha512 *ctx, const uint8_t *data, size_t blocks)
+{
+	uint64_t wk[80] __attribute__((aligned(32)));
+	
+	for (size_t i = 0; i < blocks; ++i)
+	{
+		sha512_schedule_avx512(wk, &data[i << 7]);
+		sha512_rounds(ctx->h, wk);
+	}
+}
+
+#endif
@@ -0,0 +1,215 @@
+/*
+	Copyright (C) 2009  Gabriel A. Petursson
+	
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "backends.h"
+#include "lanes.h"
+#include "sha512.h"
+
+#ifdef AMPHECK_X86
+
+/*
+	Four (AVX2) or eight (AVX-512) SHA-512 messages side by side, one per
+	64-bit lane.  As in sha256_lanes.c, blocks are transposed into
+	word-sliced vectors and the schedule is expanded in a ring of sixteen.
+*/
+
+#define S0(x) XOR3(VROR(x,  1), VROR(x,  8), SHR(x, 7))
+#define S1(x) XOR3(VROR(x, 19), VROR(x, 61), SHR(x, 6))
+#define T0(x) XOR3(VROR(x, 28), VROR(x, 34), VROR(x, 39))
+#define T1(x) XOR3(VROR(x, 14), VROR(x, 18), VROR(x, 41))
+
+#define SHA512_LANES_PRC(a, b, c, d, e, f, g, h, t) { \
+	V t1 = ADD(ADD(ADD(wv[h], T1(wv[e])), CH(wv[e], wv[f], wv[g])), ADD(w[(t) & 0x0F], SET1(sha512_k[t]))); \
+	wv[d] = ADD(wv[d], t1); \
+	wv[h] = ADD(t1, ADD(T0(wv[a]), MAJ(wv[a], wv[b], wv[c]))); \
+}
+
+#define SHA512_LANES_EXT(t) ( \
+	w[(t) & 0x0F] = ADD(ADD(w[(t) & 0x0F], S0(w[((t) + 1) & 0x0F])), ADD(S1(w[((t) - 2) & 0x0F]), w[((t) - 7) & 0x0F])) \
+)
+
+#define SHA512_LANES_RND(t) { \
+	if ((t) >= 16) \
+	{ \
+		SHA512_LANES_EXT((t)    ); SHA512_LANES_EXT((t) + 1); SHA512_LANES_EXT((t) + 2); SHA512_LANES_EXT((t) + 3); \
+		SHA512_LANES_EXT((t) + 4); SHA512_LANES_EXT((t) + 5); SHA512_LANES_EXT((t) + 6); SHA512_LANES_EXT((t) + 7); \
+	} \
+	\
+	SHA512_LANES_PRC(0, 1, 2, 3, 4, 5, 6, 7, (t)    ); \
+	SHA512_LANES_PRC(7, 0, 1, 2, 3, 4, 5, 6, (t) + 1); \
+	SHA512_LANES_PRC(6, 7, 0, 1, 2, 3, 4, 5, (t) + 2); \
+	SHA512_LANES_PRC(5, 6, 7, 0, 1, 2, 3, 4, (t) + 3); \
+	SHA512_LANES_PRC(4, 5, 6, 7, 0, 1, 2, 3, (t) + 4); \
+	SHA512_LANES_PRC(3, 4, 5, 6, 7, 0, 1, 2, (t) + 5); \
+	SHA512_LANES_PRC(2, 3, 4, 5, 6, 7, 0, 1, (t) + 6); \
+	SHA512_LANES_PRC(1, 2, 3, 4, 5, 6, 7, 0, (t) + 7); \
+}
+
+#define SHA512_LANES_BLOCK() { \
+	for (int j = 0; j < 8; ++j) \
+	{ \
+		wv[j] = s[j]; \
+	} \
+	\
+	SHA512_LANES_RND( 0); SHA512_LANES_RND( 8); SHA512_LANES_RND(16); SHA512_LANES_RND(24); SHA512_LANES_RND(32); \
+	SHA512_LANES_RND(40); SHA512_LANES_RND(48); SHA512_LANES_RND(56); SHA512_LANES_RND(64); SHA512_LANES_RND(72); \
+	\
+	for (int j = 0; j < 8; ++j) \
+	{ \
+		s[j] = ADD(s[j], wv[j]); \
+	} \
+}
+
+static const uint64_t sha512_k[80] =
+{
+	0x428a2f98d728ae22, 0x7137449123ef65cd, 0xb5c0fbcfec4d3b2f, 0xe9b5dba58189dbbc,
+	0x3956c25bf348b538, 0x59f111f1b605d019, 0x923f82a4af194f9b, 0xab1c5ed5da6d8118,
+	0xd807aa98a3030242, 0x12835b0145706fbe, 0x243185be4ee4b28c, 0x550c7dc3d5ffb4e2,
+	0x72be5d74f27b896f, 0x80deb1fe3b1696b1, 0x9bdc06a725c71235, 0xc19bf174cf692694,
+	0xe49b69c19ef14ad2, 0xefbe4786384f25e3, 0x0fc19dc68b8cd5b5, 0x240ca1cc77ac9c65,
+	0x2de92c6f592b0275, 0x4a7484aa6ea6e483, 0x5cb0a9dcbd41fbd4, 0x76f988da831153b5,
+	0x983e5152ee66dfab, 0xa831c66d2db43210, 0xb00327c898fb213f, 0xbf597fc7beef0ee4,
+	0xc6e00bf33da88fc2, 0xd5a79147930aa725, 0x06ca6351e003826f, 0x142929670a0e6e70,
+	0x27b70a8546d22ffc, 0x2e1b21385c26c926, 0x4d2c6dfc5ac42aed, 0x53380d139d95b3df,
+	0x650a73548baf63de, 0x766a0abb3c77b2a8, 0x81c2c92e47edaee6, 0x92722c851482353b,
+	0xa2bfe8a14cf10364, 0xa81a664bbc423001, 0xc24b8b70d0f89791, 0xc76c51a30654be30,
+	0xd192e819d6ef5218, 0xd69906245565a910, 0xf40e35855771202a, 0x106aa07032bbd1b8,
+	0x19a4c116b8d2d0c8, 0x1e376c085141ab53, 0x2748774cdf8eeb99, 0x34b0bcb5e19b48a8,
+	0x391c0cb3c5c95a63, 0x4ed8aa4ae3418acb, 0x5b9cca4f7763e373, 0x682e6ff3d6b2b8a3,
+	0x748f82ee5defb2fc, 0x78a5636f43172f60, 0x84c87814a1f0ab72, 0x8cc702081a6439ec,
+	0x90befffa23631e28, 0xa4506cebde82bde9, 0xbef9a3f7b2c67915, 0xc67178f2e372532b,
+	0xca273eceea26619c, 0xd186b8c721c0c207, 0xeada7dd6cde0eb1e, 0xf57d4f7fee6ed178,
+	0x06f067aa72176fba, 0x0a637dc5a2c898a6, 0x113f9804bef90dae, 0x1b710b35131c471b,
+	0x28db77f523047d84, 0x32caab7b40c72493, 0x3c9ebe0a15c9bebc, 0x431d67c49c100d4c,
+	0x4cc5d4becb3e42b6, 0x597f299cfc657e2a, 0x5fcb6fab3ad6faec, 0x6c44198c4a475817
+};
+
+#define V __m256i
+#define ADD(x, y) _mm256_add_epi64(x, y)
+#define SET1(x) _mm256_set1_epi64x((long long) (x))
+#define SHR(x, y) _mm256_srli_epi64(x, y)
+#define VROR(x, y) _mm256_or_si256(_mm256_srli_epi64(x, y), _mm256_slli_epi64(x, 64 - (y)))
+#define XOR3(x, y, z) _mm256_xor_si256(_mm256_xor_si256(x, y), z)
+#define CH(x, y, z) _mm256_xor_si256(z, _mm256_and_si256(x, _mm256_xor_si256(y, z)))
+#define MAJ(x, y, z) _mm256_or_si256(_mm256_and_si256(x, y), _mm256_and_si256(z, _mm256_or_si256(x, y)))
+
+__attribute__((target("avx2")))
+void ampheck_sha512_lanes_avx2(void *state, const uint8_t *const data[], size_t blocks)
+{
+	const __m256i mask = _mm256_set_epi8( 8,  9, 10, 11, 12, 13, 14, 15,  0,  1,  2,  3,  4,  5,  6,  7,
+	                                      8,  9, 10, 11, 12, 13, 14, 15,  0,  1,  2,  3,  4,  5,  6,  7);
+	__m256i *h = state;
+	__m256i s[8];
+	
+	for (int j = 0; j < 8; ++j)
+	{
+		s[j] = _mm256_loadu_si256(&h[j]);
+	}
+	
+	for (size_t i = 0; i < blocks; ++i)
+	{
+		__m256i wv[8];
+		__m256i w[16];
+		
+		for (int j = 0; j < 4; ++j)
+		{
+			w[j     ] = _mm256_loadu_si256((const __m256i *) &data[j][(i << 7)     ]);
+			w[j +  4] = _mm256_loadu_si256((const __m256i *) &data[j][(i << 7) + 32]);
+			w[j +  8] = _mm256_loadu_si256((const __m256i *) &data[j][(i << 7) + 64]);
+			w[j + 12] = _mm256_loadu_si256((const __m256i *) &data[j][(i << 7) + 96]);
+		}
+		
+		ampheck_transpose4_64(&w[ 0]);
+		ampheck_transpose4_64(&w[ 4]);
+		ampheck_transpose4_64(&w[ 8]);
+		ampheck_transpose4_64(&w[12]);
+		
+		for (int j = 0; j < 16; ++j)
+		{
+			w[j] = _mm256_shuffle_epi8(w[j], mask);
+		}
+		
+		SHA512_LANES_BLOCK();
+	}
+	
+	for (int j = 0; j < 8; ++j)
+	{
+		_mm256_storeu_si256(&h[j], s[j]);
+	}
+}
+
+#undef V
+#undef ADD
+#undef SET1
+#undef SHR
+#undef VROR
+#undef XOR3
+#undef CH
+#undef MAJ
+
+#define V __m512i
+#define ADD(x, y) _mm512_add_epi64(x, y)
+#define SET1(x) _mm512_set1_epi64((long long) (x))
+#define SHR(x, y) _mm512_srli_epi64(x, y)
+#define VROR(x, y) _mm512_ror_epi64(x, y)
+#define XOR3(x, y, z) _mm512_ternarylogic_epi64(x, y, z, 0x96)
+#define CH(x, y, z) _mm512_ternarylogic_epi64(x, y, z, 0xCA)
+#define MAJ(x, y, z) _mm512_ternarylogic_epi64(x, y, z, 0xE8)
+
+__attribute__((target("avx512f")))
+void ampheck_sha512_lanes_avx512(void *state, const uint8_t *const data[], size_t blocks)
+{
+	__m512i *h = state;
+	__m512i s[8];
+	
+	for (int j = 0; j < 8; ++j)
+	{
+		s[j] = _mm512_loadu_si512(&h[j]);
+	}
+	
+	for (size_t i = 0; i < blocks; ++i)
+	{
+		__m512i wv[8];
+		__m512i w[16];
+		
+		for (int j = 0; j < 8; ++j)
+		{
+			w[j    ] = _mm512_loadu_si512(&data[j][(i << 7)     ]);
+			w[j + 8] = _mm512_loadu_si512(&data[j][(i << 7) + 64]);
+		}
+		
+		ampheck_transpose8_64(&w[0]);
+		ampheck_transpose8_64(&w[8]);
+		
+		for (int j = 0; j < 16; ++j)
+		{
+			w[j] = ampheck_bswap64_avx512(w[j]);
+		}
+		
+		SHA512_LANES_BLOCK();
+	}
+	
+	for (int j = 0; j < 8; ++j)
+	{
+		_mm512_storeu_si512(&h[j], s[j]);
+	}
+}
+
+#endif